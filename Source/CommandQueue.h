@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    CommandQueue.h
+    Created: 17 Oct 2026 4:52:19pm
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    A fixed size queue any number of threads can push to and one thread (the
+    audio thread) pops from, without locks or allocation. Every cell carries a
+    sequence number saying whose turn it is, so popping never waits and a
+    push only retries when another push got the same cell first.
+
+    capacity has to be a power of two. Command gets copied in and out, keep it
+    small and trivially copyable.
+*/
+template <typename Command, int capacity>
+class CommandQueue
+{
+public:
+    static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0, "capacity has to be a power of two");
+
+    CommandQueue() {
+        for (int i = 0; i < capacity; i++) {
+            cells[i].sequence.store(size_t(i), std::memory_order_relaxed);
+        }
+    }
+
+    // Any thread. Returns false if the queue is full.
+    bool push(const Command& command) noexcept {
+        size_t pos = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            auto diff = std::ptrdiff_t(sequence) - std::ptrdiff_t(pos);
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.command = command;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            // The consumer hasn't got this far yet
+            else if (diff < 0) return false;
+            else pos = head.load(std::memory_order_relaxed);
+        }
+    }
+
+    // The consuming thread only. Returns false if there's nothing (finished) to pop.
+    bool pop(Command& command) noexcept {
+        Cell& cell = cells[tail & mask];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        if (std::ptrdiff_t(sequence) - std::ptrdiff_t(tail + 1) < 0) return false;
+
+        command = cell.command;
+        cell.sequence.store(tail + capacity, std::memory_order_release);
+        tail++;
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        Command command;
+    };
+
+    static constexpr size_t mask = capacity - 1;
+
+    Cell cells[capacity];
+    std::atomic<size_t> head{ 0 };
+    size_t tail = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (CommandQueue)
+};
@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    EpochReclaimer.h
+    Created: 17 Oct 2026 10:02:18am
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Deferred deletion for objects the audio thread reads through atomic pointers.
+
+    The audio thread wraps every access in a ReadScope, which just stamps the
+    current epoch. Other threads swap the pointer out, retire the old object and
+    collect() drops its reference once the audio thread has either left its scope
+    or started a new one after the swap. Whoever holds the last reference
+    deletes it, which is how the sample pool shares data between instances.
+    The audio thread never locks, allocates or frees anything.
+
+    Only one thread may read at a time, which is fine since that's processBlock.
+*/
+template <typename Object>
+class EpochReclaimer
+{
+public:
+    EpochReclaimer() = default;
+
+    // Nobody can be reading by the time we get destroyed, so anything still retired just goes
+    ~EpochReclaimer() = default;
+
+    struct ReadScope {
+        ReadScope(EpochReclaimer& owner) noexcept : owner(owner) {
+            owner.activeEpoch.store(owner.epoch.load());
+        }
+        ~ReadScope() noexcept {
+            owner.activeEpoch.store(idle);
+        }
+        EpochReclaimer& owner;
+    };
+
+    // Never call this on the audio thread. The object must already be unreachable from any published pointer.
+    void retire(std::shared_ptr<const Object> object) {
+        if (object == nullptr) return;
+        const juce::ScopedLock lock(retireLock);
+        retired.push_back({ std::move(object), epoch.fetch_add(1) + 1 });
+    }
+
+    // Never call this on the audio thread. Lets go of everything the reader can't be holding anymore.
+    void collect() {
+        std::vector<std::shared_ptr<const Object>> dead;
+        {
+            const juce::ScopedLock lock(retireLock);
+            // A reader that's idle reports the max epoch, so this covers both cases
+            juce::uint64 active = activeEpoch.load();
+            for (auto it = retired.begin(); it != retired.end();) {
+                if (active >= it->epoch) {
+                    dead.push_back(std::move(it->object));
+                    it = retired.erase(it);
+                }
+                else it++;
+            }
+        }
+        // Outside the lock, this might be the last reference
+        dead.clear();
+    }
+
+    bool hasRetired() {
+        const juce::ScopedLock lock(retireLock);
+        return !retired.empty();
+    }
+
+private:
+    struct Retired {
+        std::shared_ptr<const Object> object;
+        juce::uint64 epoch;
+    };
+
+    static constexpr juce::uint64 idle = std::numeric_limits<juce::uint64>::max();
+
+    std::atomic<juce::uint64> epoch{ 0 };
+    std::atomic<juce::uint64> activeEpoch{ idle };
+
+    juce::CriticalSection retireLock;
+    std::vector<Retired> retired;
+
+    JUCE_DECLARE_NON_COPYABLE (EpochReclaimer)
+};
@@ -11,11 +11,15 @@
 
 //==============================================================================
 SimplerStereoSamplerAudioProcessorEditor::SimplerStereoSamplerAudioProcessorEditor (SimplerStereoSamplerAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p)
+    : AudioProcessorEditor (&p), scopeDisplay (p.scope),
+     #if S3_TELEMETRY
+      telemetryDisplay (p.telemetry),
+     #endif
+      audioProcessor (p)
 {
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (BOX_W * 4 + 10, BOX_H * 3 + 10);
+    setSize (BOX_W * 4 + 10, BOX_H * 10 + 10);
     setResizable(false, false);
     setTitle("SimplerStereoSampler");
 
@@ -49,6 +53,12 @@ SimplerStereoSamplerAudioProcessorEditor::SimplerStereoSamplerAudioProcessorEdit
     sampleNameBox.setEditable(false, false);
     sampleNameBox.setColour(juce::Label::outlineColourId, getLookAndFeel().findColour(juce::Label::textColourId));
 
+    addAndMakeVisible(overviewDisplay);
+    addAndMakeVisible(scopeDisplay);
+   #if S3_TELEMETRY
+    addAndMakeVisible(telemetryDisplay);
+   #endif
+
     addAndMakeVisible(transposeText);
     transposeText.setJustificationType(juce::Justification::centred);
     transposeText.setEditable(false, false);
@@ -59,13 +69,33 @@ SimplerStereoSamplerAudioProcessorEditor::SimplerStereoSamplerAudioProcessorEdit
     addAndMakeVisible(transposeDownButton);
     transposeDownButton.addListener(this);
 
+    addAndMakeVisible(streamButton);
+    streamButton.addListener(this);
+
+    // Goes for every S3 on the machine, not just this one
+    addAndMakeVisible(cacheButton);
+    cacheButton.setToggleState(sampleCache->isEnabled(), juce::dontSendNotification);
+    cacheButton.addListener(this);
+
+    addAndMakeVisible(busBox);
+    busBox.addItem("Part's Output", 1);
+    busBox.addItem("Main Output", 2);
+    for (int b = 1; b < MAX_BUSES; b++) {
+        busBox.addItem("Aux " + juce::String(b), b + 2);
+    }
+    busBox.onChange = [this]() {
+        audioProcessor.synth.setSampleBus(audioProcessor.synth.getCurrentSample(), busBox.getSelectedId() - 2);
+    };
+
     updateSample();
 
     audioProcessor.addChangeListener(this);
+    audioProcessor.synth.getLoader().addListener(this);
 }
 
 SimplerStereoSamplerAudioProcessorEditor::~SimplerStereoSamplerAudioProcessorEditor()
 {
+    audioProcessor.synth.getLoader().removeListener(this);
     audioProcessor.removeChangeListener(this);
 }
 
@@ -74,46 +104,73 @@ void SimplerStereoSamplerAudioProcessorEditor::buttonClicked(juce::Button* butto
         sampleChooser.launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles, [this](const juce::FileChooser& chooser)
         {
             juce::File sampleFile(chooser.getResult());
-            int result = loadFile(sampleFile);
-            if (result >= 0) audioProcessor.synth.chooseSample(result);
+            loadFile(sampleFile);
             updateSample();
         });
     }
     else if (button == &nextSampleButton) {
-        audioProcessor.synth.chooseNextSample();
-        updateSample();
+        chooseSample(audioProcessor.synth.findNextSample());
     }
     else if (button == &prevSampleButton) {
-        audioProcessor.synth.choosePrevSample();
-        updateSample();
+        chooseSample(audioProcessor.synth.findPrevSample());
     }
     else if (button == &ejectSampleButton) {
         audioProcessor.synth.unloadSample(audioProcessor.synth.getCurrentSample());
-        audioProcessor.synth.chooseNextSample();
-        updateSample();
+        chooseSample(audioProcessor.synth.findNextSample());
     }
     else if (button == &resetButton) {
-        audioProcessor.synth.reset();
+        post({ SynthCommand::reset });
     }
     else if (button == &resetAllButton) {
-        audioProcessor.synth.resetAllSamples();
+        post({ SynthCommand::resetAll });
     }
     else if (button == &panicButton) {
-        audioProcessor.synth.noteOff();
+        post({ SynthCommand::allNotesOff });
     }
     else if (button == &transposeUpButton) {
-        audioProcessor.synth.transpose(-1);
+        post({ SynthCommand::transpose, -1 });
     }
     else if (button == &transposeDownButton) {
-        audioProcessor.synth.transpose(1);
+        post({ SynthCommand::transpose, 1 });
     }
+    else if (button == &streamButton) {
+        audioProcessor.synth.setSampleStreaming(audioProcessor.synth.getCurrentSample(), streamButton.getToggleState());
+        updateSample();
+    }
+    else if (button == &cacheButton) {
+        sampleCache->setEnabled(cacheButton.getToggleState());
+    }
+}
+
+// The synth picks it up on its next block, the label shows it as soon as it's posted
+void SimplerStereoSamplerAudioProcessorEditor::chooseSample(int slot) {
+    if (slot >= 0) post({ SynthCommand::chooseSample, slot });
+    updateSample();
+}
+
+void SimplerStereoSamplerAudioProcessorEditor::post(const SynthCommand& command) {
+    // Anything already waiting goes first, so they still happen in order
+    if (pending.empty() && audioProcessor.synth.post(command)) return;
+    pending.push_back(command);
+    startTimer(20);
 }
 
+void SimplerStereoSamplerAudioProcessorEditor::timerCallback() {
+    size_t posted = 0;
+    while (posted < pending.size() && audioProcessor.synth.post(pending[posted])) posted++;
+    pending.erase(pending.begin(), pending.begin() + posted);
+    if (pending.empty()) stopTimer();
+    if (posted > 0) updateSample();
+}
+
+// The file is decoded in the background, the slot stays silent until it's ready
 int SimplerStereoSamplerAudioProcessorEditor::loadFile(juce::File file) {
     if (file.getFileExtension() == ".wav" || file.getFileExtension() == ".flac") {
+        loadProgress = 0;
         int s = audioProcessor.synth.loadSample(file, 55.0, audioProcessor.synth.getOpenSample(), true);
         if (s >= 0) {
-            return audioProcessor.synth.chooseSample(s);
+            chooseSample(s);
+            return s;
         }
     }
     return -1;
@@ -143,6 +200,8 @@ void SimplerStereoSamplerAudioProcessorEditor::resized()
     transposeUpButton.setBounds(areaA.removeFromRight(BOX_W / 2).reduced(5));
     transposeDownButton.setBounds(areaA.reduced(5));
 
+    overviewDisplay.setBounds(bounds.removeFromTop(BOX_H * 2).reduced(5));
+
     areaA = bounds.removeFromBottom(BOX_H);
     resetButton.setBounds(areaA.removeFromRight(BOX_W).reduced(5));
     nextSampleButton.setBounds(areaA.removeFromRight(BOX_W).reduced(5));
@@ -153,6 +212,15 @@ void SimplerStereoSamplerAudioProcessorEditor::resized()
     resetAllButton.setBounds(areaA.removeFromRight(BOX_W).reduced(5));
     panicButton.setBounds(areaA.removeFromLeft(BOX_W).reduced(5));
     sampleNameBox.setBounds(areaA.reduced(5));
+
+    // What's left is the scope, with the toggles next to it
+    scopeDisplay.setBounds(bounds.removeFromLeft(bounds.getHeight()).reduced(5));
+    streamButton.setBounds(bounds.removeFromTop(BOX_H).reduced(5));
+    cacheButton.setBounds(bounds.removeFromTop(BOX_H).reduced(5));
+    busBox.setBounds(bounds.removeFromTop(BOX_H).reduced(5));
+   #if S3_TELEMETRY
+    telemetryDisplay.setBounds(bounds.reduced(5));
+   #endif
 }
 
 void SimplerStereoSamplerAudioProcessorEditor::changeListenerCallback(juce::ChangeBroadcaster* source) {
@@ -161,13 +229,44 @@ void SimplerStereoSamplerAudioProcessorEditor::changeListenerCallback(juce::Chan
     }
 }
 
+void SimplerStereoSamplerAudioProcessorEditor::sampleLoadProgress(int slot, double progress) {
+    if (slot == audioProcessor.synth.getCurrentSample()) {
+        loadProgress = progress;
+        updateSample();
+    }
+}
+
+void SimplerStereoSamplerAudioProcessorEditor::sampleLoadFinished(int slot, int result, const juce::String& error) {
+    loadProgress = 0;
+    updateSample();
+    if (result < 0 && slot == audioProcessor.synth.getCurrentSample()) {
+        // Leave the error up until something else changes the label
+        sampleNameBox.setColour(juce::Label::textColourId, juce::Colour::fromRGB(192, 40, 40));
+        sampleNameBox.setText("Slot " + juce::String(slot) + " - " + error, juce::dontSendNotification);
+    }
+}
+
+void SimplerStereoSamplerAudioProcessorEditor::sampleOverviewReady(int slot) {
+    if (slot == audioProcessor.synth.getCurrentSample()) {
+        overviewDisplay.setOverview(audioProcessor.synth.getSampleOverview(slot));
+    }
+}
+
 void SimplerStereoSamplerAudioProcessorEditor::updateSample() {
-    if (audioProcessor.synth.getCurrentSampleName() == "Not Loaded") {
+    int current = audioProcessor.synth.getCurrentSample();
+    juce::String name = audioProcessor.synth.getCurrentSampleName();
+    if (name == "Not Loaded") {
         sampleNameBox.setColour(juce::Label::textColourId, juce::Colour::fromRGB(192, 40, 40));
     }
     else {
         sampleNameBox.setColour(juce::Label::textColourId, getLookAndFeel().findColour(juce::Label::textColourId));
 
     }
-    sampleNameBox.setText("Slot " + juce::String(audioProcessor.synth.getCurrentSample()) + " - " + audioProcessor.synth.getCurrentSampleName(), juce::dontSendNotification);
+    if (audioProcessor.synth.isSampleLoading(current)) {
+        name += " (Loading " + juce::String(juce::roundToInt(loadProgress * 100.0)) + "%)";
+    }
+    sampleNameBox.setText("Slot " + juce::String(current) + " - " + name, juce::dontSendNotification);
+    streamButton.setToggleState(audioProcessor.synth.isSampleStreaming(current), juce::dontSendNotification);
+    busBox.setSelectedId(audioProcessor.synth.getSampleBus(current) + 2, juce::dontSendNotification);
+    overviewDisplay.setOverview(audioProcessor.synth.getSampleOverview(current));
 }
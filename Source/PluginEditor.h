@@ -10,6 +10,9 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "SampleOverviewDisplay.h"
+#include "ScopeDisplay.h"
+#include "TelemetryDisplay.h"
 
 #define BOX_W 120
 #define BOX_H 45
@@ -17,7 +20,7 @@
 //==============================================================================
 /**
 */
-class SimplerStereoSamplerAudioProcessorEditor  : public juce::AudioProcessorEditor, public juce::Button::Listener, public juce::ChangeListener
+class SimplerStereoSamplerAudioProcessorEditor  : public juce::AudioProcessorEditor, public juce::Button::Listener, public juce::ChangeListener, public SampleLoader::Listener, private juce::Timer
 {
 public:
     SimplerStereoSamplerAudioProcessorEditor (SimplerStereoSamplerAudioProcessor&);
@@ -31,8 +34,18 @@ public:
 
     void changeListenerCallback(juce::ChangeBroadcaster* source) override;
 
+    void sampleLoadProgress(int slot, double progress) override;
+    void sampleLoadFinished(int slot, int result, const juce::String& error) override;
+    void sampleOverviewReady(int slot) override;
+
 private:
+    void chooseSample(int slot);
+    // Posts to the synth, or if its queue's full holds on to it and keeps trying from the timer
+    void post(const SynthCommand& command);
+    void timerCallback() override;
+    std::vector<SynthCommand> pending;
     void updateSample();
+    double loadProgress = 0;
     juce::File fileToLoad{""};
     void buttonClicked(juce::Button* button) override;
 
@@ -45,11 +58,23 @@ private:
     juce::TextButton resetAllButton{ "Reset ALL" };
     juce::TextButton panicButton{ "MIDI Panic!" };
     juce::Label sampleNameBox{ "sampleNameBox", "Slot 0 - Not Loaded" };
+    SampleOverviewDisplay overviewDisplay;
+    ScopeDisplay scopeDisplay;
+   #if S3_TELEMETRY
+    TelemetryDisplay telemetryDisplay;
+   #endif
 
     juce::Label transposeText{ "transposeText", "Transpose" };
     juce::TextButton transposeUpButton{ "+1" };
     juce::TextButton transposeDownButton{ "-1" };
 
+    juce::ToggleButton streamButton{ "Stream from Disk" };
+    juce::ToggleButton cacheButton{ "Cache Decoded Files" };
+    // Which output the current slot plays on, the ids are the bus + 2
+    juce::ComboBox busBox;
+
+    juce::SharedResourcePointer<SampleCache> sampleCache;
+
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     SimplerStereoSamplerAudioProcessor& audioProcessor;
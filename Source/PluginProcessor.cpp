@@ -8,10 +8,15 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "RealtimeAudit.h"
 
 //==============================================================================
 SimplerStereoSamplerAudioProcessor::SimplerStereoSamplerAudioProcessor()
+    : juce::AudioProcessor(getBusesProperties())
 {
+   #if S3_TELEMETRY
+    synth.setTelemetry(&telemetry);
+   #endif
     synth.chooseSample(0);
     addParameter(slotNum = new juce::AudioParameterInt("slotNum", "Slot #", 0, MAX_SAMPLES - 1, 0));
     addParameter(resetOne = new juce::AudioParameterBool("resetOne", "Reset Current", false));
@@ -19,6 +24,9 @@ SimplerStereoSamplerAudioProcessor::SimplerStereoSamplerAudioProcessor()
     addParameter(resetStart = new juce::AudioParameterBool("resetStart", "Reset on Transport Start", true));
     addParameter(frequencyFactor = new juce::AudioParameterFloat("frequencyFactor", "Frequency Factor", 0.0, 1.5, 1.0));
     addParameter(tuning = new juce::AudioParameterInt("tuning", "Tuning", -100, 100, 0));
+    addParameter(voices = new juce::AudioParameterInt("voices", "Voices", 1, MAX_VOICES, 1));
+    addParameter(voiceStealing = new juce::AudioParameterChoice("voiceStealing", "Voice Stealing", { "Oldest", "Lowest", "Highest", "None" }, 0));
+    addParameter(multiTimbral = new juce::AudioParameterBool("multiTimbral", "Multi-Timbral", false));
 
     slotNum->addListener(this);
     resetOne->addListener(this);
@@ -26,30 +34,77 @@ SimplerStereoSamplerAudioProcessor::SimplerStereoSamplerAudioProcessor()
     resetStart->addListener(this);
     frequencyFactor->addListener(this);
     tuning->addListener(this);
+    voices->addListener(this);
+    voiceStealing->addListener(this);
+    multiTimbral->addListener(this);
+
+    juce::StringArray busNames{ "Main" };
+    for (int b = 1; b < MAX_BUSES; b++) {
+        busNames.add("Aux " + juce::String(b));
+    }
+    for (int p = 0; p < MAX_PARTS; p++) {
+        addParameter(partBus[p] = new juce::AudioParameterChoice("partBus" + juce::String(p + 1), "Channel " + juce::String(p + 1) + " Output", busNames, 0));
+        partBus[p]->addListener(this);
+    }
+
+    startTimer(100);
 }
 
 SimplerStereoSamplerAudioProcessor::~SimplerStereoSamplerAudioProcessor()
 {
 }
 
+// The main output, plus aux outputs that are off until the host turns them on
+juce::AudioProcessor::BusesProperties SimplerStereoSamplerAudioProcessor::getBusesProperties() {
+    BusesProperties buses = BusesProperties().withOutput("Output", juce::AudioChannelSet::stereo(), true);
+    for (int b = 1; b < MAX_BUSES; b++) {
+        buses = buses.withOutput("Aux " + juce::String(b), juce::AudioChannelSet::stereo(), false);
+    }
+    return buses;
+}
 
+
+bool SimplerStereoSamplerAudioProcessor::postParameter(const SynthCommand& command) {
+    if (synth.post(command)) return true;
+    parametersPending = true;
+    return false;
+}
+
+void SimplerStereoSamplerAudioProcessor::postLater(const SynthCommand& command) {
+    // Anything already waiting goes first, so they still happen in order
+    if (pendingCommands.empty() && synth.post(command)) return;
+    pendingCommands.push_back(command);
+}
+
+void SimplerStereoSamplerAudioProcessor::timerCallback() {
+    size_t posted = 0;
+    while (posted < pendingCommands.size() && synth.post(pendingCommands[posted])) posted++;
+    pendingCommands.erase(pendingCommands.begin(), pendingCommands.begin() + posted);
+
+    // Only the ones that are still out of step with their last value post anything
+    if (parametersPending.exchange(false)) {
+        for (juce::AudioProcessorParameter* parameter : getParameters()) {
+            parameterValueChanged(parameter->getParameterIndex(), parameter->getValue());
+        }
+    }
+}
+
+// Hosts call this from whatever thread they like, so everything goes to the synth as a command.
+// Each parameter remembers the last value that got posted, so calling this again is harmless.
 void SimplerStereoSamplerAudioProcessor::parameterValueChanged(int parameterIndex, float newValue) {
     if (parameterIndex == slotNum->getParameterIndex()) {
-        if (*slotNum != lastSlotNum) {
-            synth.chooseSample(*slotNum);
+        if (*slotNum != lastSlotNum && postParameter({ SynthCommand::chooseSample, *slotNum })) {
             lastSlotNum = *slotNum;
             sendChangeMessage();
         }
     }
     else if (parameterIndex == resetOne->getParameterIndex()) {
-        if (*resetOne != lastResetOne) {
-            synth.reset();
+        if (*resetOne != lastResetOne && postParameter({ SynthCommand::reset })) {
             lastResetOne = *resetOne;
         }
     }
     else if (parameterIndex == resetAll->getParameterIndex()) {
-        if (*resetOne != lastResetOne) {
-            synth.resetAllSamples();
+        if (*resetAll != lastResetAll && postParameter({ SynthCommand::resetAll })) {
             lastResetAll = *resetAll;
         }
     }
@@ -60,19 +115,39 @@ void SimplerStereoSamplerAudioProcessor::parameterValueChanged(int parameterInde
         }
     }
     else if (parameterIndex == frequencyFactor->getParameterIndex()) {
-        if (*frequencyFactor != lastFrequencyFactor) {
-            synth.setFrequencyFactor((*frequencyFactor - 1.0) * 48.0);
+        if (*frequencyFactor != lastFrequencyFactor && postParameter({ SynthCommand::frequencyFactor, 0, (*frequencyFactor - 1.0) * 48.0 })) {
             lastFrequencyFactor = *frequencyFactor;
         }
     }
     else if (parameterIndex == tuning->getParameterIndex()) {
-        if (*tuning != lastTuning) {
-            synth.setTuning(*tuning);
+        if (*tuning != lastTuning && postParameter({ SynthCommand::tuning, *tuning })) {
             lastTuning = *tuning;
         }
     }
+    else if (parameterIndex == voices->getParameterIndex()) {
+        if (*voices != lastVoices && postParameter({ SynthCommand::polyphony, *voices })) {
+            lastVoices = *voices;
+        }
+    }
+    else if (parameterIndex == voiceStealing->getParameterIndex()) {
+        if (voiceStealing->getIndex() != lastVoiceStealing && postParameter({ SynthCommand::voiceStealing, voiceStealing->getIndex() })) {
+            lastVoiceStealing = voiceStealing->getIndex();
+        }
+    }
+    else if (parameterIndex == multiTimbral->getParameterIndex()) {
+        if (*multiTimbral != lastMultiTimbral && postParameter({ SynthCommand::multiTimbral, *multiTimbral ? 1 : 0 })) {
+            lastMultiTimbral = *multiTimbral;
+        }
+    }
     else {
-        return;
+        for (int p = 0; p < MAX_PARTS; p++) {
+            if (parameterIndex == partBus[p]->getParameterIndex()) {
+                if (partBus[p]->getIndex() != lastPartBus[p] && postParameter({ SynthCommand::bus, partBus[p]->getIndex(), 0, p })) {
+                    lastPartBus[p] = partBus[p]->getIndex();
+                }
+                return;
+            }
+        }
     }
 }
 
@@ -130,6 +205,10 @@ void SimplerStereoSamplerAudioProcessor::changeProgramName (int index, const juc
 void SimplerStereoSamplerAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
 {
     synth.prepareToPlay(sampleRate);
+    scope.prepare(sampleRate);
+   #if S3_TELEMETRY
+    telemetry.prepare(sampleRate);
+   #endif
 }
 
 void SimplerStereoSamplerAudioProcessor::releaseResources()
@@ -138,8 +217,23 @@ void SimplerStereoSamplerAudioProcessor::releaseResources()
     // spare memory, etc.
 }
 
+// Stereo normally, but anything up to as many channels as a sample can have is fine. Sample channels
+// play into the output channels with the same number, so e.g. a third (Z) channel needs three outputs.
+// The aux buses are the same, or off.
+bool SimplerStereoSamplerAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+{
+    int numChannels = layouts.getMainOutputChannels();
+    if (layouts.getMainInputChannels() != 0 || numChannels < 1 || numChannels > SampleData::maxChannels) return false;
+    for (int b = 1; b < layouts.outputBuses.size(); b++) {
+        if (layouts.getNumChannels(false, b) > SampleData::maxChannels) return false;
+    }
+    return true;
+}
+
 void SimplerStereoSamplerAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    const RealtimeAudit::ScopedRender renderAudit;
+    S3_TELEMETRY_BLOCK(telemetry, buffer.getNumSamples());
     juce::ScopedNoDenormals noDenormals;
     int totalNumInputChannels  = getTotalNumInputChannels();
     int totalNumOutputChannels = getTotalNumOutputChannels();
@@ -154,71 +248,94 @@ void SimplerStereoSamplerAudioProcessor::processBlock (juce::AudioBuffer<float>&
         buffer.clear (i, 0, buffer.getNumSamples());
 
 
-    std::vector<MidiOnOff> mid;
-    MidiOnOff tempMid;
+    // Anything the UI or the host asked for since the last block. Whatever's for the start of the block
+    // has already happened by the time this returns.
+    synth.beginBlock(buffer.getNumSamples());
+
+    // The transport starting counts as an event at the very start of the block, ahead of any MIDI there
     juce::AudioPlayHead* transport = getPlayHead();
-    auto transportState = transport->getPosition();
-    if (transportState.hasValue()) {
-        if (transportState->getIsPlaying() && lastPlaying == false) {
-            tempMid.time = 0;
-            tempMid.note = 0;
-            tempMid.on = true;
-            tempMid.transport = true;
-            tempMid.cc = false;
-            mid.push_back(tempMid);
+    if (transport != nullptr) {
+        auto transportState = transport->getPosition();
+        if (transportState.hasValue()) {
+            if (transportState->getIsPlaying() && lastPlaying == false && *resetStart) {
+                // Transport is starting and we want to reset when that happens
+                synth.resetAllSamples();
+            }
+            lastPlaying = transportState->getIsPlaying();
         }
-        lastPlaying = transportState->getIsPlaying();
     }
-    for (auto it : midiMessages)
+
+    // The synth writes each bus's channels right where they are in the host's buffer, a bus that's
+    // off gets no channels and whatever's routed to it plays on the main one
+    int numSamples = buffer.getNumSamples();
+    int numBuses = juce::jmin(getBusCount(false), MAX_BUSES);
+    for (int b = 0; b < numBuses; b++) {
+        const Bus* bus = getBus(false, b);
+        int channels = bus->isEnabled() ? bus->getNumberOfChannels() : 0;
+        int first = channels > 0 ? bus->getChannelIndexInProcessBlockBuffer(0) : 0;
+        busBuffers[b].setDataToReferTo(buffer.getArrayOfWritePointers() + first, channels, numSamples);
+    }
+
+    // The MidiBuffer is already in time order, so just render up to each event as we get to it
+    int timeNow = 0;
+    // The synth's own idea of it, the parameter can be ahead of it while the command's queued
+    bool multi = synth.isMultiTimbral();
+    for (const auto metadata : midiMessages)
     {
-        juce::MidiMessage msg = it.getMessage();
-        if (msg.isNoteOnOrOff()) {
-            tempMid.time = int(msg.getTimeStamp());
-            tempMid.note = msg.getNoteNumber();
-            tempMid.on = msg.isNoteOn();
-            tempMid.transport = false;
-            tempMid.cc = false;
-            mid.push_back(tempMid);
+        // Anything longer is sysex, which we don't use (and which would allocate to copy)
+        if (metadata.numBytes > 3) continue;
+        juce::MidiMessage msg = metadata.getMessage();
+        if (msg.isNoteOnOrOff() == false && msg.isPitchWheel() == false) {
+            // Multi-timbral parts also listen to program changes, bank select, fine tuning and resets
+            if (multi == false || (msg.isProgramChange() == false && msg.isController() == false)) continue;
         }
-        if (msg.isPitchWheel()) {
-            tempMid.time = int(msg.getTimeStamp());
-            tempMid.note = msg.getPitchWheelValue();
-            tempMid.on = true;
-            tempMid.transport = false;
-            tempMid.cc = true;
-            mid.push_back(tempMid);
+
+        // Every channel gets its own part in multi-timbral mode, otherwise they all play the first one
+        int part = multi ? msg.getChannel() - 1 : 0;
+
+        int eventTime = juce::jlimit(timeNow, numSamples, metadata.samplePosition);
+        if (eventTime > timeNow) {
+            synth.processBlock(busBuffers, numBuses, timeNow, eventTime);
+            timeNow = eventTime;
         }
-    }
-    std::sort(mid.begin(), mid.end(), MidiOnOff::sortTime);
-    int timeNow = 0;
-    int numMessages = int(mid.size());
-    int messageNow = 0;
-    if (numMessages == 0) {
-        synth.processBlock(buffer, 0, buffer.getNumSamples());
-    }
-    else {
-        while (messageNow < numMessages) {
-            if (mid[messageNow].time > timeNow) {
-                synth.processBlock(buffer, timeNow, mid[messageNow].time);
-                timeNow = mid[messageNow].time;
+        if (msg.isPitchWheel()) {
+            // This is a pitch bend
+            float bend = (msg.getPitchWheelValue() - 8192) / 8192.f;
+            if (part == 0) pitchBend = bend;
+            synth.setPitchBend(bend, part);
+        } else if (msg.isProgramChange()) {
+            // Picks the part's slot, out of the bank it's on
+            synth.chooseSample(bank[part] * 128 + msg.getProgramChangeNumber(), part);
+        } else if (msg.isController()) {
+            int number = msg.getControllerNumber();
+            int value = msg.getControllerValue();
+            if (number == 0) {
+                bank[part] = (value << 7) | (bank[part] & 127);
+            } else if (number == 32) {
+                bank[part] = (bank[part] & ~127) | value;
+            } else if (number == 102 && value >= 64) {
+                // Like the reset buttons, for just this channel
+                synth.resetPart(part);
+            } else if (number == 103 && value >= 64) {
+                synth.resetAllSamples(part);
             }
-            if (mid[messageNow].cc) {
-                // This is a pitch bend
-                pitchBend = (mid[messageNow].note - 8192) / 8192.f;
-                synth.setPitchBend(pitchBend);
-            } else if (mid[messageNow].transport == false) {
-                // This is a midi note, handle that
-                synth.noteMessage(mid[messageNow].note, mid[messageNow].on);
-            } else if (*resetStart && (mid[messageNow].on == true)) {
-                // Transport is starting and we want to reset when that happens
-                synth.resetAllSamples();
+            // RPN 1 is fine tuning, +-100 cents
+            auto rpn = rpnDetector.tryParse(msg.getChannel(), number, value);
+            if (rpn.has_value() && rpn->isNRPN == false && rpn->parameterNumber == 1) {
+                synth.setFineTuning((rpn->value - 8192) / 8192.0 * 100.0, part);
             }
-            messageNow++;
-        }
-        if (timeNow < buffer.getNumSamples()) {
-            synth.processBlock(buffer, timeNow, buffer.getNumSamples());
+        } else {
+            // This is a midi note, handle that
+            synth.noteMessage(msg.getNoteNumber(), msg.isNoteOn(), part);
         }
     }
+    if (timeNow < numSamples) {
+        synth.processBlock(busBuffers, numBuses, timeNow, numSamples);
+    }
+
+    if (buffer.getNumChannels() >= 2) {
+        scope.push(buffer.getReadPointer(0), buffer.getReadPointer(1), numSamples);
+    }
 }
 
 //==============================================================================
@@ -256,6 +373,13 @@ void SimplerStereoSamplerAudioProcessor::getStateInformation (juce::MemoryBlock&
 
     s3->setAttribute("pitchBend", pitchBend);
 
+    s3->setAttribute("voices", *voices);
+    s3->setAttribute("voiceStealing", voiceStealing->getIndex());
+    s3->setAttribute("multiTimbral", *multiTimbral);
+    for (int p = 0; p < MAX_PARTS; p++) {
+        s3->setAttribute("partBus" + juce::String(p + 1), partBus[p]->getIndex());
+    }
+
     synth.getXmlState(s3.get());
     copyXmlToBinary(*s3, destData);
 }
@@ -277,18 +401,28 @@ void SimplerStereoSamplerAudioProcessor::setStateInformation (const void* data,
             *resetStart = s3State->getBoolAttribute("resetStart", true);
             lastResetStart = s3State->getBoolAttribute("lastResetStart", true);
 
+            // These two get posted below whatever their last values were
             *frequencyFactor = float(s3State->getDoubleAttribute("frequencyFactor", 1.0));
-            lastFrequencyFactor = float(s3State->getDoubleAttribute("lastFrequencyFactor", 1.0));
+            lastFrequencyFactor = *frequencyFactor;
 
             *tuning = s3State->getIntAttribute("tuning", 0);
-            lastTuning = s3State->getIntAttribute("lastTuning", 0);
+            lastTuning = *tuning;
 
             pitchBend = s3State->getDoubleAttribute("pitchBendFactor", 0.0);
 
-            synth.loadXmlState(s3State->getChildByName("Synth"));
+            *voices = s3State->getIntAttribute("voices", 1);
+            *voiceStealing = s3State->getIntAttribute("voiceStealing", 0);
+            *multiTimbral = s3State->getBoolAttribute("multiTimbral", false);
+            for (int p = 0; p < MAX_PARTS; p++) {
+                *partBus[p] = s3State->getIntAttribute("partBus" + juce::String(p + 1), 0);
+            }
 
-            synth.setTuning(*tuning);
-            synth.setPitchBend(pitchBend);
+            std::vector<SynthCommand> restore;
+            synth.loadXmlState(s3State->getChildByName("Synth"), restore);
+            restore.push_back({ SynthCommand::frequencyFactor, 0, (*frequencyFactor - 1.0) * 48.0 });
+            restore.push_back({ SynthCommand::tuning, *tuning });
+            restore.push_back({ SynthCommand::pitchBend, 0, pitchBend });
+            for (const SynthCommand& command : restore) postLater(command);
         }
     }
 }
@@ -10,24 +10,12 @@
 
 #include <JuceHeader.h>
 #include "SamplerSynthesizer.h"
-
-struct MidiOnOff {
-    int time = 0;
-    int note = 0;
-    bool on = false;
-    bool transport = false;
-    bool cc = false;
-    static bool sortTime(const MidiOnOff& a, const MidiOnOff& b)
-    {
-        return a.time < b.time;
-    }
-};
-
+#include "ScopeFeed.h"
 
 //==============================================================================
 /**
 */
-class SimplerStereoSamplerAudioProcessor : public juce::AudioProcessor, public juce::AudioProcessorParameter::Listener, public juce::ChangeBroadcaster
+class SimplerStereoSamplerAudioProcessor : public juce::AudioProcessor, public juce::AudioProcessorParameter::Listener, public juce::ChangeBroadcaster, private juce::Timer
 {
 public:
     //==============================================================================
@@ -43,9 +31,7 @@ public:
     void prepareToPlay (double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
 
-   #ifndef JucePlugin_PreferredChannelConfigurations
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
-   #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
 
@@ -72,7 +58,13 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+   #if S3_TELEMETRY
+    // Declared first so it's still around while the synth's threads shut down
+    Telemetry telemetry;
+   #endif
     SamplerSynthesizer synth;
+    // What we're playing, for the editor's scope
+    ScopeFeed scope;
 
     juce::AudioParameterInt* slotNum;
     juce::AudioParameterBool* resetOne;
@@ -82,15 +74,42 @@ public:
     juce::AudioParameterFloat* frequencyFactor;
     juce::AudioParameterInt* tuning;
 
+    juce::AudioParameterInt* voices;
+    juce::AudioParameterChoice* voiceStealing;
+    juce::AudioParameterBool* multiTimbral;
+    // Where each MIDI channel's part plays the slots that don't pick their own output
+    juce::AudioParameterChoice* partBus[MAX_PARTS];
+
 private:
+    static BusesProperties getBusesProperties();
+
+    // Any thread. Posts a parameter's command, if the queue's full it returns false and the timer runs
+    // parameterValueChanged for everything again later, so the parameter's last value has to stay put.
+    bool postParameter(const SynthCommand& command);
+    // Message thread. Posts the command, or holds on to it (and anything after it) until the timer can.
+    void postLater(const SynthCommand& command);
+    void timerCallback() override;
+    std::vector<SynthCommand> pendingCommands;
+    std::atomic<bool> parametersPending{ false };
+
+    // Each output bus's channels of the block, pointing straight into the host's buffer
+    juce::AudioBuffer<float> busBuffers[MAX_BUSES];
+
     int lastSlotNum = 0;
     bool lastResetOne = false;
     bool lastResetAll = false;
     bool lastResetStart = true;
     bool lastPlaying = false;
-    float lastFrequencyFactor;
+    float lastFrequencyFactor = 1.0f;
     float pitchBend = 0.f; // -1 to +1
-    int lastTuning;
+    int lastTuning = 0;
+    int lastVoices = 1;
+    int lastVoiceStealing = 0;
+    bool lastMultiTimbral = false;
+    int lastPartBus[MAX_PARTS] = {};
+    juce::MidiRPNDetector rpnDetector;
+    // Each multi-timbral part's bank select, MSB * 128 + LSB. Program changes pick a slot in it.
+    int bank[MAX_PARTS] = {};
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SimplerStereoSamplerAudioProcessor)
 };
@@ -0,0 +1,206 @@
+/*
+  ==============================================================================
+
+    RealtimeAudit.cpp
+    Created: 17 Oct 2026 1:14:32pm
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "RealtimeAudit.h"
+
+#if S3_RT_AUDIT
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <dlfcn.h>
+ #include <pthread.h>
+ #include <semaphore.h>
+#endif
+
+// These get looked at from inside malloc, so on Linux they have to live in static TLS, otherwise the first
+// look from a new thread can end up allocating (and coming right back here)
+#if JUCE_LINUX
+ #define S3_AUDIT_THREAD_LOCAL __attribute__((tls_model("initial-exec"))) thread_local
+#else
+ #define S3_AUDIT_THREAD_LOCAL thread_local
+#endif
+
+namespace {
+    S3_AUDIT_THREAD_LOCAL bool rendering = false;
+    // Set while a violation is being reported, since reporting allocates and locks too
+    S3_AUDIT_THREAD_LOCAL bool reporting = false;
+    std::atomic<int> violations{ 0 };
+
+    // The same violation usually happens every block, only print stack traces for the first few
+    constexpr int maxReports = 32;
+}
+
+RealtimeAudit::ScopedRender::ScopedRender()
+    : wasRendering(rendering)
+{
+    rendering = true;
+}
+
+RealtimeAudit::ScopedRender::~ScopedRender()
+{
+    rendering = wasRendering;
+}
+
+void RealtimeAudit::check(const char* what) {
+    if (rendering == false || reporting) return;
+
+    reporting = true;
+    if (++violations <= maxReports) {
+        juce::Logger::writeToLog(juce::String("S3 RT audit: ") + what + " called while rendering\n" + juce::SystemStats::getStackBacktrace());
+    }
+    jassertfalse;
+    reporting = false;
+}
+
+int RealtimeAudit::getNumViolations() {
+    return violations;
+}
+
+//==============================================================================
+// The allocator. On Linux this goes straight to glibc so operator new doesn't get reported twice
+// (once here and once in malloc).
+#if JUCE_LINUX
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t num, size_t size);
+    void* __libc_realloc(void* ptr, size_t size);
+    void __libc_free(void* ptr);
+
+    void* malloc(size_t size) {
+        RealtimeAudit::check("malloc");
+        return __libc_malloc(size);
+    }
+    void* calloc(size_t num, size_t size) {
+        RealtimeAudit::check("calloc");
+        return __libc_calloc(num, size);
+    }
+    void* realloc(void* ptr, size_t size) {
+        RealtimeAudit::check("realloc");
+        return __libc_realloc(ptr, size);
+    }
+    void free(void* ptr) {
+        if (ptr != nullptr) RealtimeAudit::check("free");
+        __libc_free(ptr);
+    }
+}
+
+static void* rawAllocate(size_t size) {
+    return __libc_malloc(size == 0 ? 1 : size);
+}
+static void rawFree(void* ptr) {
+    __libc_free(ptr);
+}
+#else
+static void* rawAllocate(size_t size) {
+    return std::malloc(size == 0 ? 1 : size);
+}
+static void rawFree(void* ptr) {
+    std::free(ptr);
+}
+#endif
+
+void* operator new(size_t size) {
+    RealtimeAudit::check("operator new");
+    if (void* ptr = rawAllocate(size)) return ptr;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) {
+    RealtimeAudit::check("operator new[]");
+    if (void* ptr = rawAllocate(size)) return ptr;
+    throw std::bad_alloc();
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    RealtimeAudit::check("operator new");
+    return rawAllocate(size);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    RealtimeAudit::check("operator new[]");
+    return rawAllocate(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr != nullptr) RealtimeAudit::check("operator delete");
+    rawFree(ptr);
+}
+void operator delete[](void* ptr) noexcept {
+    if (ptr != nullptr) RealtimeAudit::check("operator delete[]");
+    rawFree(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+void operator delete[](void* ptr, size_t) noexcept {
+    operator delete[](ptr);
+}
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    operator delete(ptr);
+}
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    operator delete[](ptr);
+}
+
+//==============================================================================
+// Blocking calls. CriticalSection, WaitableEvent and friends all end up in here on Linux/Mac.
+#if JUCE_LINUX || JUCE_MAC
+namespace {
+    // Looked up the first time each one's called rather than by a static initialiser, something else's
+    // static init can lock a mutex before ours have run. The pointers are constant initialised, so
+    // they're already null by then. Two threads racing here just look up the same thing twice.
+    template <typename Function>
+    Function findNext(std::atomic<Function>& next, const char* name) {
+        Function function = next.load(std::memory_order_relaxed);
+        if (function == nullptr) {
+            function = reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+            next.store(function, std::memory_order_relaxed);
+        }
+        return function;
+    }
+
+    std::atomic<int (*)(pthread_mutex_t*)> nextMutexLock{ nullptr };
+    std::atomic<int (*)(pthread_rwlock_t*)> nextReadLock{ nullptr };
+    std::atomic<int (*)(pthread_rwlock_t*)> nextWriteLock{ nullptr };
+    std::atomic<int (*)(pthread_cond_t*, pthread_mutex_t*)> nextCondWait{ nullptr };
+    std::atomic<int (*)(sem_t*)> nextSemWait{ nullptr };
+}
+
+extern "C" {
+    int pthread_mutex_lock(pthread_mutex_t* mutex) {
+        RealtimeAudit::check("pthread_mutex_lock");
+        return findNext(nextMutexLock, "pthread_mutex_lock")(mutex);
+    }
+    int pthread_rwlock_rdlock(pthread_rwlock_t* lock) {
+        RealtimeAudit::check("pthread_rwlock_rdlock");
+        return findNext(nextReadLock, "pthread_rwlock_rdlock")(lock);
+    }
+    int pthread_rwlock_wrlock(pthread_rwlock_t* lock) {
+        RealtimeAudit::check("pthread_rwlock_wrlock");
+        return findNext(nextWriteLock, "pthread_rwlock_wrlock")(lock);
+    }
+    int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex) {
+        RealtimeAudit::check("pthread_cond_wait");
+        return findNext(nextCondWait, "pthread_cond_wait")(cond, mutex);
+    }
+    int sem_wait(sem_t* sem) {
+        RealtimeAudit::check("sem_wait");
+        return findNext(nextSemWait, "sem_wait")(sem);
+    }
+}
+#endif
+
+#else
+
+void RealtimeAudit::check(const char*) {
+}
+
+int RealtimeAudit::getNumViolations() {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,50 @@
+/*
+  ==============================================================================
+
+    RealtimeAudit.h
+    Created: 17 Oct 2026 1:14:32pm
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Catches things the audio thread shouldn't be doing. Only does anything in
+    builds with S3_RT_AUDIT=1 (the RTAudit configuration), where operator
+    new/delete get replaced, and on Linux/Mac malloc and the pthread locking
+    calls too. Any of those made by a thread inside a ScopedRender gets logged
+    with a stack trace and trips an assertion.
+
+    Only calls made from the plugin's own code (JUCE included) get caught,
+    whatever the host does in its own libraries is invisible to us.
+*/
+class RealtimeAudit
+{
+public:
+    // Put one of these at the top of anything that runs on the audio thread
+    class ScopedRender {
+    public:
+       #if S3_RT_AUDIT
+        ScopedRender();
+        ~ScopedRender();
+       #else
+        ScopedRender() {}
+       #endif
+
+    private:
+       #if S3_RT_AUDIT
+        bool wasRendering;
+       #endif
+        JUCE_DECLARE_NON_COPYABLE (ScopedRender)
+    };
+
+    // Reports a violation if the calling thread is rendering, what is the name of the call
+    static void check(const char* what);
+
+    // How many violations have happened since the plugin was loaded
+    static int getNumViolations();
+};
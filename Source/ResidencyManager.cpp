@@ -0,0 +1,294 @@
+/*
+  ==============================================================================
+
+    ResidencyManager.cpp
+    Created: 17 Oct 2026 8:12:37pm
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "ResidencyManager.h"
+#include "SamplerSynthesizer.h"
+
+#if ! JUCE_WINDOWS
+ #include <sys/mman.h>
+#endif
+
+//==============================================================================
+PagePinner::PagePinner()
+    : pageSize(size_t(juce::SystemStats::getPageSize()))
+{
+}
+
+bool PagePinner::pin(const std::vector<SampleData::Region>& regions) {
+   #if JUCE_WINDOWS
+    juce::ignoreUnused(regions);
+    return false;
+   #else
+    std::vector<std::uintptr_t> pages;
+    getPages(regions, pages);
+    if (pages.empty()) return false;
+
+    const juce::ScopedLock sl(lock);
+    std::vector<std::uintptr_t> fresh;
+    for (auto page : pages) {
+        if (counts.find(page) == counts.end()) fresh.push_back(page);
+    }
+    if (pinnedBytes + fresh.size() * pageSize > budget) return false;
+
+    size_t numLocked = lockPages(fresh, true);
+    // Probably over the OS's limit
+    if (numLocked < fresh.size()) {
+        fresh.resize(numLocked);
+        lockPages(fresh, false);
+        return false;
+    }
+    for (auto page : pages) counts[page]++;
+    pinnedBytes += fresh.size() * pageSize;
+    return true;
+   #endif
+}
+
+void PagePinner::unpin(const std::vector<SampleData::Region>& regions) {
+    std::vector<std::uintptr_t> pages;
+    getPages(regions, pages);
+
+    const juce::ScopedLock sl(lock);
+    std::vector<std::uintptr_t> freed;
+    for (auto page : pages) {
+        auto found = counts.find(page);
+        if (found == counts.end()) continue;
+        if (--found->second == 0) {
+            freed.push_back(page);
+            counts.erase(found);
+        }
+    }
+    lockPages(freed, false);
+    pinnedBytes -= freed.size() * pageSize;
+}
+
+// Sorted with no repeats, so a page two regions share only gets counted once
+void PagePinner::getPages(const std::vector<SampleData::Region>& regions, std::vector<std::uintptr_t>& pages) const {
+    for (auto& region : regions) {
+        if (region.size == 0) continue;
+        auto address = reinterpret_cast<std::uintptr_t>(region.data);
+        for (auto page = address / pageSize; page <= (address + region.size - 1) / pageSize; page++) pages.push_back(page);
+    }
+    std::sort(pages.begin(), pages.end());
+    pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+}
+
+size_t PagePinner::lockPages(const std::vector<std::uintptr_t>& pages, bool lockThem) const {
+   #if JUCE_WINDOWS
+    juce::ignoreUnused(pages, lockThem);
+    return 0;
+   #else
+    size_t first = 0;
+    while (first < pages.size()) {
+        size_t last = first + 1;
+        while (last < pages.size() && pages[last] == pages[last - 1] + 1) last++;
+
+        void* start = reinterpret_cast<void*>(pages[first] * pageSize);
+        size_t size = (last - first) * pageSize;
+        if (lockThem) {
+            if (mlock(start, size) != 0) return first;
+        }
+        else {
+            munlock(start, size);
+        }
+        first = last;
+    }
+    return first;
+   #endif
+}
+
+//==============================================================================
+ResidencyManager::ResidencyManager(SamplerSynthesizer& owner)
+    : juce::Thread("S3 Residency"), owner(owner)
+{
+    startThread(juce::Thread::Priority::low);
+    startTimerHz(updateRate);
+}
+
+ResidencyManager::~ResidencyManager()
+{
+    stopTimer();
+    stopThread(4000);
+}
+
+// Message thread. Works out which slots should be resident and hands them to the thread if that's changed.
+void ResidencyManager::timerCallback() {
+    int numParts = owner.multiTimbral ? MAX_PARTS : 1;
+
+    // Slots in the order they matter, with the part whose position in them counts
+    std::vector<std::pair<int, int>> wanted;
+    auto want = [&wanted](int slot, int part) {
+        if (slot < 0) return;
+        for (auto& w : wanted) {
+            if (w.first == slot) return;
+        }
+        wanted.push_back({ slot, part });
+    };
+
+    for (int p = 0; p < numParts; p++) {
+        int current = owner.parts[p].selectedSample;
+        if (current < 0) continue;
+        want(current, p);
+
+        auto found = std::find(recentSlots.begin(), recentSlots.end(), current);
+        if (found != recentSlots.begin()) {
+            if (found != recentSlots.end()) recentSlots.erase(found);
+            recentSlots.insert(recentSlots.begin(), current);
+        }
+    }
+    if (int(recentSlots.size()) > maxRecent) recentSlots.resize(maxRecent);
+
+    for (int p = 0; p < numParts; p++) {
+        int next = owner.parts[p].selectedSample;
+        int prev = next;
+        if (next < 0) continue;
+        for (int n = 0; n < neighbours; n++) {
+            next = owner.samples.findNextOccupied(next);
+            prev = owner.samples.findPrevOccupied(prev);
+            want(next, p);
+            want(prev, p);
+        }
+    }
+    for (int i = 0; i < juce::jmin(recent, int(recentSlots.size())); i++) {
+        want(recentSlots[size_t(i)], 0);
+    }
+
+    std::vector<Target> targets;
+    std::vector<juce::int64> keys;
+    {
+        const juce::ScopedLock lock(owner.slotLock);
+        for (auto& w : wanted) {
+            SampleSlot* slot = owner.samples.find(w.first);
+            if (slot == nullptr || slot->owner == nullptr) continue;
+            juce::int64 frame = juce::int64(slot->samplePhase[w.second].load() >> 32);
+            keys.push_back(juce::int64(juce::pointer_sized_int(slot->owner.get())));
+            keys.push_back(frame);
+            targets.push_back({ slot->owner, frame });
+        }
+    }
+    if (keys == lastKeys) return;
+    lastKeys = std::move(keys);
+
+    {
+        const juce::ScopedLock lock(targetLock);
+        std::swap(pendingTargets, targets);
+        targetsChanged = true;
+    }
+    notify();
+}
+
+void ResidencyManager::run() {
+    std::vector<Target> targets;
+    size_t budget = pinner->getBudget();
+    while (!threadShouldExit()) {
+        bool changed = false;
+        {
+            const juce::ScopedLock lock(targetLock);
+            if (targetsChanged) {
+                std::swap(targets, pendingTargets);
+                pendingTargets.clear();
+                targetsChanged = false;
+                changed = true;
+            }
+        }
+        if (changed || budget != pinner->getBudget()) {
+            budget = pinner->getBudget();
+            update(targets);
+        }
+        else {
+            for (auto& resident : residents) {
+                if (resident.locked == false) touch(resident);
+            }
+        }
+        wait(touchInterval);
+    }
+
+    for (auto& resident : residents) release(resident);
+    residents.clear();
+    lockedBytes = 0;
+}
+
+// Locks as many targets as fit in the budget, in order, and touches the rest. Anything that isn't a
+// target anymore gets unlocked and let go of.
+void ResidencyManager::update(std::vector<Target>& targets) {
+    std::vector<Resident> next;
+    for (auto& target : targets) {
+        auto found = std::find_if(residents.begin(), residents.end(), [&target](const Resident& r) { return r.data == target.data; });
+        if (found != residents.end()) {
+            next.push_back(std::move(*found));
+            found->data = nullptr;
+        }
+        else {
+            next.push_back({});
+            next.back().data = target.data;
+        }
+        next.back().frame = target.frame;
+    }
+    for (auto& resident : residents) {
+        if (resident.data != nullptr) release(resident);
+    }
+    residents = std::move(next);
+
+    // The budget went down, start over so what's left goes to the ones that matter most
+    if (pinner->getPinnedBytes() > pinner->getBudget()) {
+        for (auto& resident : residents) release(resident);
+    }
+
+    size_t used = 0;
+    for (size_t i = 0; i < residents.size(); i++) {
+        if (threadShouldExit()) break;
+
+        auto& resident = residents[i];
+        if (resident.locked == false) {
+            resident.regions.clear();
+            resident.data->getRegions(0, resident.data->getNumFrames(), resident.regions);
+            resident.size = 0;
+            for (auto& region : resident.regions) resident.size += region.size;
+
+            bool pinned = resident.size > 0 && pinner->pin(resident.regions);
+            // Make room by letting go of the ones after this, they matter less
+            if (pinned == false && resident.size > 0) {
+                for (size_t j = i + 1; j < residents.size(); j++) release(residents[j]);
+                pinned = pinner->pin(resident.regions);
+            }
+            resident.locked = pinned;
+        }
+
+        if (resident.locked) used += resident.size;
+        else touch(resident);
+    }
+    lockedBytes = used;
+}
+
+// Unlocks whatever's locked, keeps the data
+void ResidencyManager::release(Resident& resident) {
+    if (resident.locked) pinner->unpin(resident.regions);
+    resident.locked = false;
+}
+
+// Reads a byte of every page around where the slot starts playing, and at its start
+void ResidencyManager::touch(const Resident& resident) {
+    juce::int64 frames = juce::int64(resident.data->getSampleRate() * touchSeconds);
+    size_t page = size_t(juce::SystemStats::getPageSize());
+    std::vector<SampleData::Region> regions;
+    resident.data->getRegions(resident.frame, frames, regions);
+    resident.data->getRegions(0, frames, regions);
+    resident.data->touch(resident.frame, frames);
+    resident.data->touch(0, frames);
+    for (auto& region : regions) {
+        const volatile char* bytes = static_cast<const char*>(region.data);
+       #if ! JUCE_WINDOWS
+        auto address = reinterpret_cast<std::uintptr_t>(region.data);
+        auto aligned = address & ~std::uintptr_t(page - 1);
+        posix_madvise(reinterpret_cast<void*>(aligned), region.size + (address - aligned), POSIX_MADV_WILLNEED);
+       #endif
+        for (size_t b = 0; b < region.size; b += page) (void) bytes[b];
+    }
+}
@@ -0,0 +1,165 @@
+/*
+  ==============================================================================
+
+    ResidencyManager.h
+    Created: 17 Oct 2026 8:12:37pm
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "SampleData.h"
+
+class SamplerSynthesizer;
+
+//==============================================================================
+/*
+    Locks pages into RAM for every ResidencyManager in the process, get it with
+    a juce::SharedResourcePointer<PagePinner>. Samples are shared between
+    instances and separate allocations can share a page, so each page is
+    counted and only unlocked once nobody wants it anymore. There's one
+    budget for the whole process.
+
+    Windows only locks as much as the process's minimum working set allows,
+    which is nowhere near enough to be useful, so there nothing gets pinned
+    and the ResidencyManager touches everything instead.
+*/
+class PagePinner
+{
+public:
+    PagePinner();
+
+    // Locks every page the regions cover, unless the ones that aren't locked yet would go over the budget
+    // or the OS says no. All or nothing, returns false if nothing changed.
+    bool pin(const std::vector<SampleData::Region>& regions);
+    // Undoes a pin() of the same regions that worked
+    void unpin(const std::vector<SampleData::Region>& regions);
+
+    // Most bytes to lock, 0 turns locking off. Only stops new pins, whatever's locked stays locked.
+    void setBudget(size_t bytes) {
+        budget = bytes;
+    }
+    size_t getBudget() const {
+        return budget;
+    }
+    size_t getPinnedBytes() const {
+        return pinnedBytes;
+    }
+
+private:
+    // Adds the first page number of every region, its last one and everything in between to pages
+    void getPages(const std::vector<SampleData::Region>& regions, std::vector<std::uintptr_t>& pages) const;
+    // Locks or unlocks runs of consecutive pages, pages has to be sorted. Locking stops at the first
+    // failure and returns how many pages it got through.
+    size_t lockPages(const std::vector<std::uintptr_t>& pages, bool lockThem) const;
+
+    const size_t pageSize;
+    std::atomic<size_t> budget{ size_t(512) << 20 };
+    std::atomic<size_t> pinnedBytes{ 0 };
+
+    juce::CriticalSection lock;
+    // How many pins each locked page has
+    std::unordered_map<std::uintptr_t, int> counts;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PagePinner)
+};
+
+//==============================================================================
+/*
+    Keeps the slots that are playing, or likely to be played next, in RAM so
+    switching to one never page faults on the audio thread. Every part's
+    current slot comes first, then the loaded slots either side of it (where
+    slot automation goes next), then the slots that were played recently.
+
+    As many of those as fit in the PagePinner's budget get their pages
+    locked. The rest get the frames around where
+    they'll start playing from touched every so often, which is usually
+    enough to keep the OS from paging them out. Files played straight from
+    their memory mapping are always touched, never locked.
+
+    The message thread works out which slots those are, the locking and
+    touching happens on a thread of its own since it can wait on the disk.
+*/
+class ResidencyManager : private juce::Thread, private juce::Timer
+{
+public:
+    ResidencyManager(SamplerSynthesizer& owner);
+    ~ResidencyManager() override;
+
+    // Loaded slots either side of each part's current one
+    void setNeighbours(int num) {
+        neighbours = juce::jlimit(0, maxNeighbours, num);
+    }
+    int getNeighbours() const {
+        return neighbours;
+    }
+
+    // Slots that were current before
+    void setRecent(int num) {
+        recent = juce::jlimit(0, maxRecent, num);
+    }
+    int getRecent() const {
+        return recent;
+    }
+
+    // Most bytes to lock, 0 turns locking off (slots still get touched). Shared by every S3 in the process.
+    void setLockBudget(size_t bytes) {
+        pinner->setBudget(bytes);
+        notify();
+    }
+    // What this one has locked, pages other instances also locked count here too
+    size_t getLockedBytes() const {
+        return lockedBytes;
+    }
+
+private:
+    struct Target {
+        std::shared_ptr<const SampleData> data;
+        // Where it'll start playing from
+        juce::int64 frame = 0;
+    };
+
+    struct Resident {
+        std::shared_ptr<const SampleData> data;
+        juce::int64 frame = 0;
+        bool locked = false;
+        size_t size = 0;
+        std::vector<SampleData::Region> regions;
+    };
+
+    void timerCallback() override;
+    void run() override;
+    void update(std::vector<Target>& targets);
+    void release(Resident& resident);
+    void touch(const Resident& resident);
+
+    static constexpr int maxNeighbours = 16;
+    static constexpr int maxRecent = 64;
+    // How often (Hz) the message thread checks which slots should be resident
+    static constexpr int updateRate = 20;
+    // How often (ms) slots that aren't locked get touched again
+    static constexpr int touchInterval = 1000;
+    // Seconds touched from where a slot starts playing, and from its start (where loops and resets go)
+    static constexpr double touchSeconds = 2.0;
+
+    SamplerSynthesizer& owner;
+    int neighbours = 2;
+    int recent = 4;
+    juce::SharedResourcePointer<PagePinner> pinner;
+
+    // Message thread only. Slots in the order they were last current, and what was last sent to the thread.
+    std::vector<int> recentSlots;
+    std::vector<juce::int64> lastKeys;
+
+    juce::CriticalSection targetLock;
+    std::vector<Target> pendingTargets;
+    bool targetsChanged = false;
+
+    // Our thread only
+    std::vector<Resident> residents;
+    std::atomic<size_t> lockedBytes{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ResidencyManager)
+};
@@ -0,0 +1,190 @@
+/*
+  ==============================================================================
+
+    SampleCache.cpp
+    Created: 17 Oct 2026 3:26:44pm
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "SampleCache.h"
+
+//==============================================================================
+SampleCache::SampleCache()
+{
+    juce::PropertiesFile::Options options;
+    options.applicationName = "S3";
+    options.folderName = "S3";
+    options.filenameSuffix = "settings";
+    options.osxLibrarySubFolder = "Application Support";
+    settings.reset(new juce::PropertiesFile(options));
+}
+
+SampleCache::~SampleCache()
+{
+    settings->saveIfNeeded();
+}
+
+bool SampleCache::isEnabled() {
+    const juce::ScopedLock sl(lock);
+    return settings->getBoolValue("cacheEnabled", false);
+}
+
+void SampleCache::setEnabled(bool shouldBeEnabled) {
+    const juce::ScopedLock sl(lock);
+    settings->setValue("cacheEnabled", shouldBeEnabled);
+}
+
+// Next to the settings file unless somebody moved it
+juce::File SampleCache::getDirectory() {
+    const juce::ScopedLock sl(lock);
+    return juce::File(settings->getValue("cacheDirectory", settings->getFile().getSiblingFile("Cache").getFullPathName()));
+}
+
+void SampleCache::setDirectory(const juce::File& directory) {
+    const juce::ScopedLock sl(lock);
+    settings->setValue("cacheDirectory", directory.getFullPathName());
+}
+
+juce::int64 SampleCache::getMaxSize() {
+    const juce::ScopedLock sl(lock);
+    return settings->getValue("cacheMaxSize", juce::String(defaultMaxSize)).getLargeIntValue();
+}
+
+void SampleCache::setMaxSize(juce::int64 bytes) {
+    const juce::ScopedLock sl(lock);
+    settings->setValue("cacheMaxSize", juce::String(bytes));
+}
+
+// One entry per source path, so a file that changed on disk just gets its entry replaced
+juce::File SampleCache::getCacheFile(const juce::File& source, bool int16) {
+    return getDirectory().getChildFile(juce::String::toHexString(source.getFullPathName().hashCode64()) + (int16 ? "-16" : "") + ".s3cache");
+}
+
+std::shared_ptr<const SampleData> SampleCache::open(const juce::File& source, bool int16) {
+    if (isEnabled() == false) return nullptr;
+    juce::File cacheFile = getCacheFile(source, int16);
+    if (cacheFile.existsAsFile() == false) return nullptr;
+
+    std::unique_ptr<juce::MemoryMappedFile> map(new juce::MemoryMappedFile(cacheFile, juce::MemoryMappedFile::readOnly));
+    if (map->getData() == nullptr || map->getSize() < sizeof(Header)) return nullptr;
+
+    const char* base = static_cast<const char*>(map->getData());
+    Header header;
+    std::memcpy(&header, base, sizeof(Header));
+    if (std::memcmp(header.magic, "S3DC", 4) != 0 || header.version != version) return nullptr;
+    if (header.sourceSize != source.getSize() || header.sourceTime != source.getLastModificationTime().toMilliseconds()) return nullptr;
+    if (header.numFrames < 1 || header.numFrames > SampleData::maxFrames) return nullptr;
+    if (header.bytesPerSample != (int16 ? sizeof(juce::int16) : sizeof(float))) return nullptr;
+    if (header.numChannels < 1 || header.numChannels > SampleData::maxChannels) return nullptr;
+
+    // Written somewhere with smaller pages than ours, the channels wouldn't start on a page here
+    size_t alignment = header.alignment;
+    size_t page = size_t(juce::SystemStats::getPageSize());
+    if (alignment < sizeof(Header) || (alignment & (alignment - 1)) != 0 || alignment % page != 0) return nullptr;
+    if (map->getSize() < alignment) return nullptr;
+
+    // Two paths can hash to the same name
+    if (header.pathBytes > alignment - sizeof(Header)) return nullptr;
+    if (juce::String::fromUTF8(base + sizeof(Header), int(header.pathBytes)) != source.getFullPathName()) return nullptr;
+
+    size_t stride = roundUp(size_t(header.numFrames) * header.bytesPerSample, alignment);
+    if (map->getSize() < alignment + stride * header.numChannels) return nullptr;
+
+    cacheFile.setLastAccessTime(juce::Time::getCurrentTime());
+    return std::make_shared<const CachedSampleData>(std::move(map), header.numFrames, int(header.numChannels), header.sampleRate, int16, alignment, stride);
+}
+
+std::shared_ptr<const SampleData> SampleCache::store(const juce::File& source, const SampleChunks<float>& frames, double sampleRate) {
+    return storeFrames(source, frames, sampleRate);
+}
+
+std::shared_ptr<const SampleData> SampleCache::store(const juce::File& source, const SampleChunks<juce::int16>& frames, double sampleRate) {
+    return storeFrames(source, frames, sampleRate);
+}
+
+template <typename Type>
+std::shared_ptr<const SampleData> SampleCache::storeFrames(const juce::File& source, const SampleChunks<Type>& frames, double sampleRate) {
+    if (isEnabled() == false) return nullptr;
+    juce::File directory = getDirectory();
+    if (directory.createDirectory().failed()) return nullptr;
+
+    juce::String path = source.getFullPathName();
+    size_t pathBytes = path.getNumBytesAsUTF8();
+    size_t alignment = getAlignment();
+    if (pathBytes > alignment - sizeof(Header)) return nullptr;
+
+    Header header = {};
+    std::memcpy(header.magic, "S3DC", 4);
+    header.version = version;
+    header.sourceSize = source.getSize();
+    header.sourceTime = source.getLastModificationTime().toMilliseconds();
+    header.numFrames = frames.getNumFrames();
+    header.sampleRate = sampleRate;
+    header.pathBytes = juce::uint32(pathBytes);
+    header.bytesPerSample = juce::uint32(sizeof(Type));
+    header.numChannels = juce::uint32(frames.getNumChannels());
+    header.alignment = juce::uint32(alignment);
+
+    bool int16 = sizeof(Type) == sizeof(juce::int16);
+    size_t bytes = size_t(frames.getNumFrames()) * sizeof(Type);
+    size_t stride = roundUp(bytes, alignment);
+
+    // Written under another name first so nobody maps a half written entry
+    juce::File cacheFile = getCacheFile(source, int16);
+    juce::File temp = directory.getNonexistentChildFile(cacheFile.getFileNameWithoutExtension(), ".tmp", false);
+    {
+        juce::FileOutputStream out(temp);
+        if (out.failedToOpen()) return nullptr;
+        out.write(&header, sizeof(Header));
+        out.write(path.toRawUTF8(), pathBytes);
+        out.writeRepeatedByte(0, alignment - sizeof(Header) - pathBytes);
+        for (int c = 0; c < frames.getNumChannels(); c++) {
+            frames.forEachRun(0, frames.getNumFrames(), [&](juce::int64 frame, int run) {
+                out.write(frames.getPointer(c, frame), size_t(run) * sizeof(Type));
+            });
+            out.writeRepeatedByte(0, stride - bytes);
+        }
+        out.flush();
+        if (out.getStatus().failed()) {
+            temp.deleteFile();
+            return nullptr;
+        }
+    }
+    if (temp.moveFileTo(cacheFile) == false) {
+        temp.deleteFile();
+        return nullptr;
+    }
+
+    trim(cacheFile);
+    return open(source, int16);
+}
+
+void SampleCache::trim(const juce::File& keep) {
+    juce::File directory = getDirectory();
+    juce::int64 maxSize = getMaxSize();
+
+    // Leftovers from a store that never finished
+    juce::Time stale = juce::Time::getCurrentTime() - juce::RelativeTime::hours(1);
+    for (const juce::File& file : directory.findChildFiles(juce::File::findFiles, false, "*.tmp")) {
+        if (file.getLastModificationTime() < stale) file.deleteFile();
+    }
+
+    juce::Array<juce::File> entries = directory.findChildFiles(juce::File::findFiles, false, "*.s3cache");
+    std::sort(entries.begin(), entries.end(), [](const juce::File& a, const juce::File& b) {
+        return a.getLastAccessTime() < b.getLastAccessTime();
+    });
+
+    juce::int64 total = 0;
+    for (const juce::File& file : entries) total += file.getSize();
+
+    for (const juce::File& file : entries) {
+        if (total <= maxSize) break;
+        if (file == keep) continue;
+        juce::int64 size = file.getSize();
+        // Somebody might still have it mapped, on Windows that means it stays
+        if (file.deleteFile()) total -= size;
+    }
+}
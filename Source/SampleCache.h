@@ -0,0 +1,137 @@
+/*
+  ==============================================================================
+
+    SampleCache.h
+    Created: 17 Oct 2026 3:26:44pm
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "SampleData.h"
+
+//==============================================================================
+/*
+    A file that's been decoded before, played straight out of its cache file.
+    Each channel starts on its own page. Float frames are used right where
+    they are in the mapping, 16 bit ones get converted like CompactSampleData.
+*/
+class CachedSampleData : public SampleData
+{
+public:
+    CachedSampleData(std::unique_ptr<juce::MemoryMappedFile> map, juce::int64 numFrames, int numChannels, double sampleRate, bool int16, size_t channelOffset, size_t channelStride)
+        : SampleData(numFrames, numChannels, sampleRate), map(std::move(map)), int16(int16)
+    {
+        const char* base = static_cast<const char*>(this->map->getData());
+        for (int c = 0; c < numChannels; c++) {
+            channels[c] = base + channelOffset + channelStride * size_t(c);
+        }
+    }
+
+    void getFrames(juce::int64 start, int num, const float** dest, float* const* scratch) const noexcept override {
+        for (int c = 0; c < numChannels; c++) {
+            if (int16) {
+                dest[c] = scratch[c];
+                convertInt16(reinterpret_cast<const juce::int16*>(channels[c]) + start, scratch[c], num);
+            }
+            else {
+                dest[c] = reinterpret_cast<const float*>(channels[c]) + start;
+            }
+        }
+    }
+
+    void getRegions(juce::int64 start, juce::int64 num, std::vector<Region>& regions) const override {
+        if (clipFrames(start, num) == false) return;
+        size_t bytesPerSample = int16 ? sizeof(juce::int16) : sizeof(float);
+        for (int c = 0; c < numChannels; c++) {
+            regions.push_back({ channels[c] + size_t(start) * bytesPerSample, size_t(num) * bytesPerSample });
+        }
+    }
+
+private:
+    const std::unique_ptr<juce::MemoryMappedFile> map;
+    const bool int16;
+    const char* channels[maxChannels] = {};
+
+    JUCE_LEAK_DETECTOR (CachedSampleData)
+};
+
+//==============================================================================
+/*
+    An optional on-disk cache of decoded files, shared by every S3 on the
+    machine. Compressed files get decoded once and written out as raw planar
+    floats (or 16 bit ints), every channel the file had, after that loading them is just mapping the cache file.
+
+    Entries are keyed by the source file's path, size and modification time
+    and the cache is kept under its size limit by deleting whatever was used
+    least recently. The settings live in S3's settings file, get it with a
+    juce::SharedResourcePointer<SampleCache>.
+*/
+class SampleCache
+{
+public:
+    SampleCache();
+    ~SampleCache();
+
+    bool isEnabled();
+    void setEnabled(bool shouldBeEnabled);
+
+    juce::File getDirectory();
+    void setDirectory(const juce::File& directory);
+
+    juce::int64 getMaxSize();
+    void setMaxSize(juce::int64 bytes);
+
+    // Returns null if source isn't cached or its cache file is out of date. 16 bit and float copies of a file
+    // are cached separately.
+    std::shared_ptr<const SampleData> open(const juce::File& source, bool int16);
+
+    // Writes the decoded source out and returns it mapped from the cache, or null if it couldn't be written
+    std::shared_ptr<const SampleData> store(const juce::File& source, const SampleChunks<float>& frames, double sampleRate);
+    // Same for a 16 bit file
+    std::shared_ptr<const SampleData> store(const juce::File& source, const SampleChunks<juce::int16>& frames, double sampleRate);
+
+    // Deletes the least recently used entries until the cache fits, keep is never deleted
+    void trim(const juce::File& keep = {});
+
+private:
+    struct Header {
+        char magic[4];
+        juce::uint32 version;
+        juce::int64 sourceSize;
+        juce::int64 sourceTime;
+        juce::int64 numFrames;
+        double sampleRate;
+        juce::uint32 pathBytes;
+        juce::uint32 bytesPerSample;
+        juce::uint32 numChannels;
+        // What the header and every channel are padded to, see getAlignment()
+        juce::uint32 alignment;
+    };
+
+    juce::File getCacheFile(const juce::File& source, bool int16);
+    template <typename Type>
+    std::shared_ptr<const SampleData> storeFrames(const juce::File& source, const SampleChunks<Type>& frames, double sampleRate);
+
+    static constexpr juce::uint32 version = 4;
+    static constexpr juce::int64 defaultMaxSize = juce::int64(8) << 30;
+    // Entries get written with at least this alignment, so the same cache works on 4k and 16k page machines
+    static constexpr size_t minAlignment = 16384;
+
+    // Our page size or minAlignment, whichever's bigger. Anything that's a multiple of the page size
+    // we're running with can be opened.
+    static size_t getAlignment() {
+        return juce::jmax(minAlignment, size_t(juce::SystemStats::getPageSize()));
+    }
+
+    static size_t roundUp(size_t bytes, size_t alignment) {
+        return (bytes + alignment - 1) & ~(alignment - 1);
+    }
+
+    juce::CriticalSection lock;
+    std::unique_ptr<juce::PropertiesFile> settings;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleCache)
+};
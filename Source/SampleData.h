@@ -0,0 +1,302 @@
+/*
+  ==============================================================================
+
+    SampleData.h
+    Created: 17 Oct 2026 10:02:18am
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Everything the audio thread needs to play a slot. Once it's been published
+    to a slot it never changes, a reload publishes a whole new one instead.
+
+    Subclasses decide where the frames actually live, the renderer only ever
+    asks for a window of them at a time through getFrames().
+*/
+class SampleData
+{
+public:
+    // Most frames a sample can have. Playback positions are 32.32 fixed point, so the frame has to fit in the top
+    // half, with room to spare for the step past the end. That's a bit over three hours at 384k.
+    static constexpr juce::int64 maxFrames = (juce::int64(1) << 32) - (juce::int64(1) << 20);
+    // Most channels a sample keeps, anything past that in a file is dropped
+    static constexpr int maxChannels = 8;
+
+    SampleData(juce::int64 numFrames, int numChannels, double sampleRate)
+        : numFrames(numFrames), numChannels(numChannels), sampleRate(sampleRate)
+    {
+        jassert(numFrames <= maxFrames);
+        jassert(numChannels >= 1 && numChannels <= maxChannels);
+    }
+    virtual ~SampleData() = default;
+
+    juce::int64 getNumFrames() const {
+        return numFrames;
+    }
+
+    // As many as the file had, mono is kept mono
+    int getNumChannels() const {
+        return numChannels;
+    }
+
+    double getSampleRate() const {
+        return sampleRate;
+    }
+
+    // True if it can only be read from one place at a time, like a stream with its one read-ahead window
+    virtual bool isSingleReader() const noexcept {
+        return false;
+    }
+
+    // Audio thread. Points dest at frames [start, start + num) of every channel, either straight into the
+    // sample's own memory or into scratch, which has room for num frames of getNumChannels() channels. Never
+    // blocks, anything that isn't available right now comes back as silence.
+    virtual void getFrames(juce::int64 start, int num, const float** dest, float* const* scratch) const noexcept = 0;
+
+    struct Region {
+        const void* data = nullptr;
+        size_t size = 0;
+    };
+
+    // Where frames [start, start + num) live in memory, for the ResidencyManager to keep them there. Adds them
+    // to regions, which isn't cleared first. Anything that isn't in memory as such has none.
+    virtual void getRegions(juce::int64 start, juce::int64 num, std::vector<Region>& regions) const {
+    }
+
+    // For frames that are in memory but can't be handed out as regions. Reads a bit of every page of
+    // [start, start + num) so the OS doesn't page them out.
+    virtual void touch(juce::int64 start, juce::int64 num) const {
+    }
+
+protected:
+    // Clips a range of frames to the sample, false if there's nothing left of it
+    bool clipFrames(juce::int64& start, juce::int64& num) const noexcept {
+        start = juce::jlimit(juce::int64(0), numFrames, start);
+        num = juce::jlimit(juce::int64(0), numFrames - start, num);
+        return num > 0;
+    }
+
+    // Same scale JUCE's readers use for 16 bit files, so this gives exactly what decoding straight to float would.
+    // Simple enough for the compiler to vectorise.
+    static void convertInt16(const juce::int16* source, float* dest, int num) noexcept {
+        constexpr float scale = 1.0f / 32768.0f;
+        for (int i = 0; i < num; i++) {
+            dest[i] = float(source[i]) * scale;
+        }
+    }
+
+    const juce::int64 numFrames;
+    const int numChannels;
+    const double sampleRate;
+
+    JUCE_DECLARE_NON_COPYABLE (SampleData)
+};
+
+//==============================================================================
+/*
+    Every channel of a decoded sample, in chunks of chunkFrames instead of one
+    block, so an hours long file never needs one huge allocation (and doesn't
+    run into AudioBuffer's int sized channels). Each chunk holds its frames of
+    channel 0, then channel 1 and so on, only the last one is shorter.
+*/
+template <typename Type>
+class SampleChunks
+{
+public:
+    static constexpr int chunkBits = 20;
+    static constexpr int chunkFrames = 1 << chunkBits;
+
+    SampleChunks(juce::int64 numFrames, int numChannels)
+        : numFrames(numFrames), numChannels(numChannels)
+    {
+        for (juce::int64 pos = 0; pos < numFrames; pos += chunkFrames) {
+            chunks.emplace_back(size_t(getChunkLength(pos)) * size_t(numChannels));
+        }
+    }
+
+    SampleChunks(SampleChunks&&) = default;
+
+    juce::int64 getNumFrames() const noexcept {
+        return numFrames;
+    }
+
+    int getNumChannels() const noexcept {
+        return numChannels;
+    }
+
+    // False if there wasn't enough memory for all of it
+    bool isValid() const noexcept {
+        for (auto& chunk : chunks) {
+            if (chunk == nullptr) return false;
+        }
+        return true;
+    }
+
+    Type* getPointer(int channel, juce::int64 frame) noexcept {
+        return chunks[size_t(frame >> chunkBits)] + channel * getChunkLength(frame) + int(frame & (chunkFrames - 1));
+    }
+    const Type* getPointer(int channel, juce::int64 frame) const noexcept {
+        return chunks[size_t(frame >> chunkBits)] + channel * getChunkLength(frame) + int(frame & (chunkFrames - 1));
+    }
+
+    // Calls function(frame, num) for each piece of [start, start + num) that's all in one chunk, in order
+    template <typename Function>
+    void forEachRun(juce::int64 start, juce::int64 num, Function&& function) const {
+        while (num > 0) {
+            int run = int(juce::jmin(num, juce::int64(chunkFrames - int(start & (chunkFrames - 1)))));
+            function(start, run);
+            start += run;
+            num -= run;
+        }
+    }
+
+    // Frames from frame to the end of its chunk
+    int getRunLength(juce::int64 frame) const noexcept {
+        return int(juce::jmin(numFrames - frame, juce::int64(chunkFrames - int(frame & (chunkFrames - 1)))));
+    }
+
+private:
+    int getChunkLength(juce::int64 frame) const noexcept {
+        juce::int64 chunkStart = frame & ~juce::int64(chunkFrames - 1);
+        return int(juce::jmin(juce::int64(chunkFrames), numFrames - chunkStart));
+    }
+
+    juce::int64 numFrames;
+    int numChannels;
+    std::vector<juce::HeapBlock<Type>> chunks;
+
+    JUCE_DECLARE_NON_COPYABLE (SampleChunks)
+};
+
+//==============================================================================
+/*
+    The whole file decoded into memory.
+*/
+class BufferedSampleData : public SampleData
+{
+public:
+    BufferedSampleData(SampleChunks<float> frames, double sampleRate)
+        : SampleData(frames.getNumFrames(), frames.getNumChannels(), sampleRate), frames(std::move(frames))
+    {
+    }
+
+    void getFrames(juce::int64 start, int num, const float** dest, float* const* scratch) const noexcept override {
+        // Inside one chunk they can be used right where they are, across two they have to be copied together
+        if (frames.getRunLength(start) >= num) {
+            for (int c = 0; c < numChannels; c++) dest[c] = frames.getPointer(c, start);
+            return;
+        }
+        for (int c = 0; c < numChannels; c++) dest[c] = scratch[c];
+        frames.forEachRun(start, num, [&](juce::int64 frame, int run) {
+            int offset = int(frame - start);
+            for (int c = 0; c < numChannels; c++) {
+                juce::FloatVectorOperations::copy(scratch[c] + offset, frames.getPointer(c, frame), run);
+            }
+        });
+    }
+
+    void getRegions(juce::int64 start, juce::int64 num, std::vector<Region>& regions) const override {
+        if (clipFrames(start, num) == false) return;
+        frames.forEachRun(start, num, [&](juce::int64 frame, int run) {
+            for (int c = 0; c < numChannels; c++) {
+                regions.push_back({ frames.getPointer(c, frame), size_t(run) * sizeof(float) });
+            }
+        });
+    }
+
+private:
+    const SampleChunks<float> frames;
+
+    JUCE_LEAK_DETECTOR (BufferedSampleData)
+};
+
+//==============================================================================
+/*
+    A 16 bit file decoded into memory but kept at 16 bits, half the size of
+    BufferedSampleData. The frames get converted as the renderer asks for them.
+*/
+class CompactSampleData : public SampleData
+{
+public:
+    CompactSampleData(SampleChunks<juce::int16> frames, double sampleRate)
+        : SampleData(frames.getNumFrames(), frames.getNumChannels(), sampleRate), frames(std::move(frames))
+    {
+    }
+
+    void getFrames(juce::int64 start, int num, const float** dest, float* const* scratch) const noexcept override {
+        for (int c = 0; c < numChannels; c++) dest[c] = scratch[c];
+        frames.forEachRun(start, num, [&](juce::int64 frame, int run) {
+            int offset = int(frame - start);
+            for (int c = 0; c < numChannels; c++) {
+                convertInt16(frames.getPointer(c, frame), scratch[c] + offset, run);
+            }
+        });
+    }
+
+    void getRegions(juce::int64 start, juce::int64 num, std::vector<Region>& regions) const override {
+        if (clipFrames(start, num) == false) return;
+        frames.forEachRun(start, num, [&](juce::int64 frame, int run) {
+            for (int c = 0; c < numChannels; c++) {
+                regions.push_back({ frames.getPointer(c, frame), size_t(run) * sizeof(juce::int16) });
+            }
+        });
+    }
+
+private:
+    const SampleChunks<juce::int16> frames;
+
+    JUCE_LEAK_DETECTOR (CompactSampleData)
+};
+
+//==============================================================================
+/*
+    An uncompressed file played straight out of a memory mapping, so loading is
+    just mapping the file and instances that use the same file share its pages.
+    The frames get converted to float as the renderer asks for them.
+*/
+class MappedSampleData : public SampleData
+{
+public:
+    // The reader can't have more than maxChannels channels
+    MappedSampleData(std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader)
+        : SampleData(reader->lengthInSamples, int(reader->numChannels), reader->sampleRate), reader(std::move(reader))
+    {
+    }
+
+    void getFrames(juce::int64 start, int num, const float** dest, float* const* scratch) const noexcept override {
+        for (int c = 0; c < numChannels; c++) dest[c] = scratch[c];
+
+        // Same trick AudioFormatReader uses, read the raw frames into the float buffer and convert in place
+        int* const* raw = reinterpret_cast<int* const*>(scratch);
+        if (reader->read(raw, numChannels, start, num, false) == false) {
+            for (int c = 0; c < numChannels; c++) juce::FloatVectorOperations::clear(scratch[c], num);
+        }
+        else if (reader->usesFloatingPointData == false) {
+            for (int c = 0; c < numChannels; c++) {
+                juce::FloatVectorOperations::convertFixedToFloat(scratch[c], raw[c], 1.0f / float(0x7fffffff), num);
+            }
+        }
+    }
+
+    // The reader doesn't say where its mapping is, so there are no regions to lock, but every page can
+    // still be touched through it
+    void touch(juce::int64 start, juce::int64 num) const override {
+        if (clipFrames(start, num) == false) return;
+        juce::int64 bytesPerFrame = juce::int64(reader->numChannels) * juce::int64(reader->bitsPerSample) / 8;
+        juce::int64 step = juce::jmax(juce::int64(1), juce::int64(juce::SystemStats::getPageSize()) / juce::jmax(juce::int64(1), bytesPerFrame));
+        for (juce::int64 frame = start; frame < start + num; frame += step) {
+            reader->touchSample(frame);
+        }
+    }
+
+private:
+    const std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader;
+
+    JUCE_LEAK_DETECTOR (MappedSampleData)
+};
@@ -0,0 +1,315 @@
+/*
+  ==============================================================================
+
+    SampleLoader.cpp
+    Created: 17 Oct 2026 9:12:40am
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "SampleLoader.h"
+#include "SamplerSynthesizer.h"
+
+//==============================================================================
+SampleLoader::SampleLoader(SamplerSynthesizer& owner)
+    : juce::Thread("S3 Sample Loader"), owner(owner)
+{
+    manager.registerBasicFormats();
+    startThread(juce::Thread::Priority::low);
+}
+
+SampleLoader::~SampleLoader()
+{
+    stop();
+}
+
+void SampleLoader::stop() {
+    stopThread(4000);
+    cancelPendingUpdate();
+}
+
+void SampleLoader::addJob(const SampleLoadJob& job) {
+    {
+        const juce::ScopedLock lock(jobLock);
+        jobs.add(job);
+    }
+    notify();
+}
+
+bool SampleLoader::isBusy() {
+    const juce::ScopedLock lock(jobLock);
+    return working || !jobs.isEmpty();
+}
+
+bool SampleLoader::popJob(SampleLoadJob& job) {
+    const juce::ScopedLock lock(jobLock);
+    working = !jobs.isEmpty();
+    if (!working) return false;
+    job = jobs.removeAndReturn(0);
+    return true;
+}
+
+void SampleLoader::run() {
+    while (!threadShouldExit()) {
+        SampleLoadJob job;
+        if (popJob(job)) decode(job);
+        // Wake up now and then to free whatever the audio thread has let go of
+        else wait(collectInterval);
+        owner.collectGarbage();
+    }
+}
+
+void SampleLoader::decode(const SampleLoadJob& job) {
+    S3_TRACE(owner.telemetry, job.overview ? "Overview" : "Load", loaderTrack, job.slot);
+    if (job.overview) {
+        buildOverview(job);
+        return;
+    }
+
+    progressSlot = job.slot;
+    progress = 0;
+
+    if (job.stream) {
+        std::unique_ptr<juce::AudioFormatReader> reader(manager.createReaderFor(job.file));
+        if (reader == nullptr) {
+            report(job, -3, "Couldn't read " + job.file.getFileName());
+            return;
+        }
+        // Anything that fits in the head and the ring anyway isn't worth streaming
+        if (reader->lengthInSamples > StreamingSampleData::headFrames + StreamingSampleData::ringFrames
+            && reader->lengthInSamples <= SampleData::maxFrames) {
+            openStream(job, std::move(reader));
+            return;
+        }
+    }
+
+    // Everything that isn't streamed comes from the pool, so other instances with the same file share it
+    int result = 0;
+    juce::String error;
+    SamplePool::Ptr data = pool->getOrCreate(job.file, job.compact,
+        [&] { return load(job, result, error); },
+        [&] { return threadShouldExit() || owner.isLoadCancelled(job.slot, job.generation); });
+
+    if (data == nullptr) {
+        // Cancelled, nobody wants to hear about it
+        if (result < 0) report(job, result, error);
+        return;
+    }
+    progress = 1;
+    if (owner.publishSample(job.slot, job.generation, std::move(data))) {
+        report(job, job.slot, {});
+        queueOverview(job);
+    }
+}
+
+// Reads the whole file for the pool. Returns null with result and error set if that didn't work,
+// or with result left at 0 if the job got cancelled.
+SamplePool::Ptr SampleLoader::load(const SampleLoadJob& job, int& result, juce::String& error) {
+    // Uncompressed files don't need decoding at all, we can play them right out of the file
+    if (SamplePool::Ptr mapped = openMapped(job)) return mapped;
+
+    std::unique_ptr<juce::AudioFormatReader> reader(manager.createReaderFor(job.file));
+    if (reader == nullptr) {
+        result = -3;
+        error = "Couldn't read " + job.file.getFileName();
+        return nullptr;
+    }
+    if (reader->lengthInSamples < 1 || reader->lengthInSamples > SampleData::maxFrames) {
+        result = -4;
+        error = job.file.getFileName() + " is empty or too long";
+        return nullptr;
+    }
+
+    // 16 bit files lose nothing staying 16 bit, so unless we were asked not to that's how they're kept
+    bool int16 = job.compact && reader->bitsPerSample <= 16 && reader->usesFloatingPointData == false;
+
+    // Maybe it's been decoded before
+    if (SamplePool::Ptr cached = cache->open(job.file, int16)) return cached;
+    if (int16) return loadCompact(job, *reader, result, error);
+
+    juce::int64 length = reader->lengthInSamples;
+    int numChannels = getNumChannels(*reader);
+    SampleChunks<float> frames(length, numChannels);
+    if (frames.isValid() == false) {
+        result = -4;
+        error = "Not enough memory for " + job.file.getFileName();
+        return nullptr;
+    }
+
+    // A piece at a time, straight into the chunks. A piece never spans two of them.
+    static_assert(SampleChunks<float>::chunkFrames % chunkSize == 0, "Pieces have to line up with chunks");
+    float* channels[SampleData::maxChannels];
+    for (juce::int64 pos = 0; pos < length; pos += chunkSize) {
+        // The slot was ejected or reloaded while we were working on it, nobody wants this anymore
+        if (threadShouldExit() || owner.isLoadCancelled(job.slot, job.generation)) return nullptr;
+
+        int num = int(juce::jmin(juce::int64(chunkSize), length - pos));
+        for (int c = 0; c < numChannels; c++) channels[c] = frames.getPointer(c, pos);
+        if (reader->read(channels, numChannels, pos, num) == false) {
+            result = -4;
+            error = "Failed while decoding " + job.file.getFileName();
+            return nullptr;
+        }
+        progress = double(pos + num) / double(length);
+        triggerAsyncUpdate();
+    }
+
+    // Next time this file comes straight out of the cache. If it made it there, play it from there too
+    // so the decoded copy doesn't have to stay in memory.
+    if (SamplePool::Ptr cached = cache->store(job.file, frames, reader->sampleRate)) return cached;
+    return std::make_shared<const BufferedSampleData>(std::move(frames), reader->sampleRate);
+}
+
+// Same as above for a 16 bit file, which is kept that way
+SamplePool::Ptr SampleLoader::loadCompact(const SampleLoadJob& job, juce::AudioFormatReader& reader, int& result, juce::String& error) {
+    juce::int64 length = reader.lengthInSamples;
+    int numChannels = getNumChannels(reader);
+    SampleChunks<juce::int16> frames(length, numChannels);
+    if (frames.isValid() == false) {
+        result = -4;
+        error = "Not enough memory for " + job.file.getFileName();
+        return nullptr;
+    }
+
+    // The reader hands out 16 bit frames in the top half of an int
+    juce::HeapBlock<int> raw(size_t(chunkSize) * size_t(numChannels));
+    int* channels[SampleData::maxChannels];
+    for (int c = 0; c < numChannels; c++) channels[c] = raw + size_t(chunkSize) * size_t(c);
+    for (juce::int64 pos = 0; pos < length; pos += chunkSize) {
+        if (threadShouldExit() || owner.isLoadCancelled(job.slot, job.generation)) return nullptr;
+
+        int num = int(juce::jmin(juce::int64(chunkSize), length - pos));
+        if (reader.read(channels, numChannels, pos, num, false) == false) {
+            result = -4;
+            error = "Failed while decoding " + job.file.getFileName();
+            return nullptr;
+        }
+        for (int c = 0; c < numChannels; c++) {
+            juce::int16* dest = frames.getPointer(c, pos);
+            for (int i = 0; i < num; i++) {
+                dest[i] = juce::int16(channels[c][i] >> 16);
+            }
+        }
+        progress = double(pos + num) / double(length);
+        triggerAsyncUpdate();
+    }
+
+    if (SamplePool::Ptr cached = cache->store(job.file, frames, reader.sampleRate)) return cached;
+    return std::make_shared<const CompactSampleData>(std::move(frames), reader.sampleRate);
+}
+
+void SampleLoader::openStream(const SampleLoadJob& job, std::unique_ptr<juce::AudioFormatReader> reader) {
+    // Only the head gets decoded now, the streamer takes care of the rest while it plays
+    std::unique_ptr<juce::AudioBuffer<float>> head(new juce::AudioBuffer<float>(getNumChannels(*reader), StreamingSampleData::headFrames));
+    if (reader->read(head->getArrayOfWritePointers(), head->getNumChannels(), 0, StreamingSampleData::headFrames) == false) {
+        report(job, -4, "Failed while decoding " + job.file.getFileName());
+        return;
+    }
+    progress = 1;
+
+    // Streams read through this synth's streamer and keep their own position, so they're never shared
+    std::shared_ptr<const SampleData> data(new StreamingSampleData(std::move(reader), std::move(head), owner.streamer));
+    if (owner.publishSample(job.slot, job.generation, std::move(data))) {
+        report(job, job.slot, {});
+        queueOverview(job);
+    }
+}
+
+void SampleLoader::report(const SampleLoadJob& job, int result, const juce::String& error) {
+    {
+        const juce::ScopedLock lock(reportLock);
+        reports.add({ job.slot, job.generation, result, error });
+    }
+    progressSlot = -1;
+    triggerAsyncUpdate();
+}
+
+void SampleLoader::handleAsyncUpdate() {
+    juce::Array<Report> done;
+    {
+        const juce::ScopedLock lock(reportLock);
+        done.swapWith(reports);
+    }
+
+    int slot = progressSlot;
+    if (slot >= 0) {
+        double now = progress;
+        listeners.call([slot, now](Listener& l) { l.sampleLoadProgress(slot, now); });
+    }
+
+    for (auto& r : done) {
+        if (r.overview) {
+            listeners.call([&r](Listener& l) { l.sampleOverviewReady(r.slot); });
+            continue;
+        }
+        // Free up the slot that was reserved for a file that didn't make it
+        if (r.result < 0) owner.abandonLoad(r.slot, r.generation);
+        listeners.call([&r](Listener& l) { l.sampleLoadFinished(r.slot, r.result, r.error); });
+    }
+}
+
+// Returns null if the file can't be memory mapped, in which case it should be decoded like anything else
+SamplePool::Ptr SampleLoader::openMapped(const SampleLoadJob& job) {
+    juce::AudioFormat* format = manager.findFormatForFileExtension(job.file.getFileExtension());
+    if (format == nullptr) return nullptr;
+
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> reader(format->createMemoryMappedReader(job.file));
+    if (reader == nullptr) return nullptr;
+    if (reader->lengthInSamples < 1 || reader->lengthInSamples > SampleData::maxFrames) return nullptr;
+    // More channels than we keep, decoding drops the extra ones
+    if (reader->numChannels < 1 || int(reader->numChannels) > SampleData::maxChannels) return nullptr;
+    if (reader->mapEntireFile() == false) return nullptr;
+
+    return std::make_shared<const MappedSampleData>(std::move(reader));
+}
+
+// Switching a slot between streaming and not doesn't change what it sounds like, so the overview it has is still good
+void SampleLoader::queueOverview(const SampleLoadJob& job) {
+    if (owner.getSampleOverview(job.slot) != nullptr) return;
+    SampleLoadJob next = job;
+    next.overview = true;
+    addJob(next);
+}
+
+void SampleLoader::buildOverview(const SampleLoadJob& job) {
+    std::shared_ptr<const SampleData> data = owner.getSampleData(job.slot, job.generation);
+    if (data == nullptr) return;
+
+    SampleOverview::Builder builder;
+    juce::AudioBuffer<float> buffer(SampleData::maxChannels, chunkSize);
+    auto cancelled = [&] { return threadShouldExit() || owner.isLoadCancelled(job.slot, job.generation); };
+
+    // Streams only have a bit of the file in memory (and belong to the audio thread), read it from the disk again
+    if (dynamic_cast<const StreamingSampleData*>(data.get()) != nullptr) {
+        data = nullptr;
+        std::unique_ptr<juce::AudioFormatReader> reader(manager.createReaderFor(job.file));
+        if (reader == nullptr) return;
+        for (juce::int64 pos = 0; pos < reader->lengthInSamples; pos += chunkSize) {
+            if (cancelled()) return;
+            int num = int(juce::jmin(juce::int64(chunkSize), reader->lengthInSamples - pos));
+            // Mono comes back in both channels
+            if (reader->read(&buffer, 0, num, pos, true, true) == false) return;
+            builder.addFrames(buffer.getReadPointer(0), buffer.getReadPointer(1), num);
+        }
+    }
+    else {
+        for (juce::int64 pos = 0; pos < data->getNumFrames(); pos += chunkSize) {
+            if (cancelled()) return;
+            int num = int(juce::jmin(juce::int64(chunkSize), data->getNumFrames() - pos));
+            const float* frames[SampleData::maxChannels];
+            data->getFrames(pos, num, frames, buffer.getArrayOfWritePointers());
+            // The picture is of the first two channels, mono is both
+            builder.addFrames(frames[0], frames[data->getNumChannels() > 1 ? 1 : 0], num);
+        }
+    }
+
+    if (owner.setSampleOverview(job.slot, job.generation, builder.finish())) {
+        {
+            const juce::ScopedLock lock(reportLock);
+            reports.add({ job.slot, job.generation, job.slot, {}, true });
+        }
+        triggerAsyncUpdate();
+    }
+}
@@ -0,0 +1,125 @@
+/*
+  ==============================================================================
+
+    SampleLoader.h
+    Created: 17 Oct 2026 9:12:40am
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "SamplePool.h"
+#include "SampleCache.h"
+
+class SamplerSynthesizer;
+
+struct SampleLoadJob {
+    int slot = -1;
+    int generation = 0;
+    juce::File file;
+    bool stream = false;
+    // Keep 16 bit files at 16 bits instead of decoding them to float
+    bool compact = true;
+    // Build the slot's overview instead of loading it, queued once the data's been published
+    bool overview = false;
+};
+
+//==============================================================================
+/*
+    Decodes sample files on its own thread so the message thread and the audio
+    thread never have to wait on the disk or the decoder. Finished buffers are
+    handed to the synth, which publishes them to their slot atomically.
+
+    Anything that isn't streamed goes through the process-wide SamplePool, so a
+    file another instance already has loaded isn't decoded again. Compressed
+    files also go through the SampleCache when it's turned on.
+
+    Once a slot's playable it gets a SampleOverview for the editor, built after
+    every load that was already waiting.
+*/
+class SampleLoader : private juce::Thread, private juce::AsyncUpdater
+{
+public:
+    class Listener {
+    public:
+        virtual ~Listener() = default;
+
+        // Called on the message thread while a file is being decoded, progress goes from 0 to 1
+        virtual void sampleLoadProgress(int slot, double progress) {}
+
+        // Called on the message thread when a job is done, result is the slot or a negative error code
+        virtual void sampleLoadFinished(int slot, int result, const juce::String& error) {}
+
+        // Called on the message thread when a slot's overview is ready, see SamplerSynthesizer::getSampleOverview
+        virtual void sampleOverviewReady(int slot) {}
+    };
+
+    SampleLoader(SamplerSynthesizer& owner);
+    ~SampleLoader() override;
+
+    void addJob(const SampleLoadJob& job);
+
+    // Stops the thread, any job that hasn't been published yet is dropped
+    void stop();
+
+    bool isBusy();
+
+    void addListener(Listener* listener) {
+        listeners.add(listener);
+    }
+    void removeListener(Listener* listener) {
+        listeners.remove(listener);
+    }
+
+private:
+    struct Report {
+        int slot = -1;
+        int generation = 0;
+        int result = 0;
+        juce::String error;
+        bool overview = false;
+    };
+
+    void run() override;
+    void handleAsyncUpdate() override;
+
+    bool popJob(SampleLoadJob& job);
+    void decode(const SampleLoadJob& job);
+    SamplePool::Ptr load(const SampleLoadJob& job, int& result, juce::String& error);
+    SamplePool::Ptr loadCompact(const SampleLoadJob& job, juce::AudioFormatReader& reader, int& result, juce::String& error);
+    void openStream(const SampleLoadJob& job, std::unique_ptr<juce::AudioFormatReader> reader);
+    SamplePool::Ptr openMapped(const SampleLoadJob& job);
+    void queueOverview(const SampleLoadJob& job);
+    void buildOverview(const SampleLoadJob& job);
+    void report(const SampleLoadJob& job, int result, const juce::String& error);
+
+    // Channels a sample from this reader keeps, every one the file has up to SampleData::maxChannels
+    static int getNumChannels(const juce::AudioFormatReader& reader) {
+        return juce::jlimit(1, SampleData::maxChannels, int(reader.numChannels));
+    }
+
+    // Number of frames decoded between progress updates and cancellation checks
+    static constexpr int chunkSize = 1 << 16;
+    // How often (ms) the idle thread wakes up to free retired sample data
+    static constexpr int collectInterval = 250;
+
+    SamplerSynthesizer& owner;
+    juce::AudioFormatManager manager;
+    juce::SharedResourcePointer<SamplePool> pool;
+    juce::SharedResourcePointer<SampleCache> cache;
+
+    juce::CriticalSection jobLock;
+    juce::Array<SampleLoadJob> jobs;
+    bool working = false;
+
+    juce::CriticalSection reportLock;
+    juce::Array<Report> reports;
+
+    std::atomic<int> progressSlot{ -1 };
+    std::atomic<double> progress{ 0 };
+
+    juce::ListenerList<Listener> listeners;
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleLoader)
+};
@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    SampleOverview.cpp
+    Created: 17 Oct 2026 5:31:44pm
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "SampleOverview.h"
+
+//==============================================================================
+void SampleOverview::Builder::addFrames(const float* left, const float* right, int num) {
+    const float* channels[2] = { left, right };
+    for (int i = 0; i < num; i++) {
+        for (int c = 0; c < 2; c++) {
+            float value = channels[c][i];
+            if (framesInPair == 0 || value < low[c]) low[c] = value;
+            if (framesInPair == 0 || value > high[c]) high[c] = value;
+        }
+        if (++framesInPair == baseFrames) endPair();
+
+        // Left across, right up, the same way the scope draws them
+        int x = juce::jlimit(0, densitySize - 1, int((left[i] + 1.0f) * 0.5f * densitySize));
+        int y = juce::jlimit(0, densitySize - 1, int((1.0f - right[i]) * 0.5f * densitySize));
+        counts[size_t(y) * densitySize + size_t(x)]++;
+    }
+    numFrames += num;
+}
+
+void SampleOverview::Builder::endPair() {
+    // Rounded outwards so the picture never looks quieter than the sample
+    for (int c = 0; c < 2; c++) {
+        pairs.push_back(juce::int8(juce::jlimit(-127, 127, int(std::floor(low[c] * 127.0f)))));
+        pairs.push_back(juce::int8(juce::jlimit(-127, 127, int(std::ceil(high[c] * 127.0f)))));
+    }
+    framesInPair = 0;
+}
+
+std::shared_ptr<const SampleOverview> SampleOverview::Builder::finish() {
+    if (framesInPair > 0) endPair();
+
+    std::shared_ptr<SampleOverview> overview(new SampleOverview());
+    overview->numFrames = numFrames;
+    overview->levels.push_back(std::move(pairs));
+
+    // Every level up takes the widest of each two pairs below it, until there's only one
+    while (overview->levels.back().size() > 4) {
+        const std::vector<juce::int8>& below = overview->levels.back();
+        size_t numBelow = below.size() / 4;
+        std::vector<juce::int8> above((numBelow + 1) / 2 * 4);
+        for (size_t i = 0; i < numBelow; i++) {
+            juce::int8* dest = above.data() + (i / 2) * 4;
+            const juce::int8* src = below.data() + i * 4;
+            for (int k = 0; k < 4; k += 2) {
+                bool first = (i % 2) == 0;
+                dest[k] = first ? src[k] : juce::jmin(dest[k], src[k]);
+                dest[k + 1] = first ? src[k + 1] : juce::jmax(dest[k + 1], src[k + 1]);
+            }
+        }
+        overview->levels.push_back(std::move(above));
+    }
+
+    // Log scaled, otherwise everything but the middle of a quiet sample disappears
+    overview->density.resize(counts.size());
+    juce::uint32 most = *std::max_element(counts.begin(), counts.end());
+    float scale = most > 0 ? 1.0f / std::log1p(float(most)) : 0.0f;
+    for (size_t i = 0; i < counts.size(); i++) {
+        overview->density[i] = std::log1p(float(counts[i])) * scale;
+    }
+
+    counts.clear();
+    return overview;
+}
+
+//==============================================================================
+juce::Range<float> SampleOverview::getRange(int channel, juce::int64 start, juce::int64 end) const noexcept {
+    start = juce::jmax(juce::int64(0), start);
+    end = juce::jmin(numFrames, end);
+    if (levels.empty() || end <= start) return {};
+
+    // The coarsest level whose pairs still fit in the range
+    int level = 0;
+    juce::int64 frames = baseFrames;
+    while (level + 1 < int(levels.size()) && frames * 2 <= end - start) {
+        level++;
+        frames *= 2;
+    }
+
+    const std::vector<juce::int8>& pairs = levels[size_t(level)];
+    int lowest = 127;
+    int highest = -127;
+    for (juce::int64 i = start / frames; i <= (end - 1) / frames; i++) {
+        lowest = juce::jmin(lowest, int(pairs[size_t(i) * 4 + size_t(channel) * 2]));
+        highest = juce::jmax(highest, int(pairs[size_t(i) * 4 + size_t(channel) * 2 + 1]));
+    }
+    return { lowest / 127.0f, highest / 127.0f };
+}
@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+    SampleOverview.h
+    Created: 17 Oct 2026 5:31:44pm
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    A small picture of a whole sample for the editor, so it never has to look
+    at the sample itself. There's a min/max pyramid for the waveform, every
+    level summing up twice as many frames as the one below, and an XY (left
+    across, right up, like the scope) density grid.
+
+    Built on the loader thread with a Builder, never changes after that.
+*/
+class SampleOverview
+{
+public:
+    // Frames per min/max pair at the finest level
+    static constexpr int baseFrames = 256;
+    // The density grid is densitySize by densitySize
+    static constexpr int densitySize = 128;
+
+    class Builder {
+    public:
+        Builder() = default;
+
+        // Call with the frames in order, as many at a time as you like
+        void addFrames(const float* left, const float* right, int num);
+        // The Builder is spent after this
+        std::shared_ptr<const SampleOverview> finish();
+
+    private:
+        void endPair();
+
+        std::vector<juce::int8> pairs;
+        float low[2] = { 0, 0 };
+        float high[2] = { 0, 0 };
+        int framesInPair = 0;
+        juce::int64 numFrames = 0;
+        std::vector<juce::uint32> counts = std::vector<juce::uint32>(size_t(densitySize) * size_t(densitySize));
+
+        JUCE_DECLARE_NON_COPYABLE (Builder)
+    };
+
+    juce::int64 getNumFrames() const noexcept {
+        return numFrames;
+    }
+
+    // Lowest and highest value of a channel (roughly, to 1/127) from start up to end, read from the
+    // coarsest level that's still fine enough, so it's a handful of lookups however long the range is
+    juce::Range<float> getRange(int channel, juce::int64 start, juce::int64 end) const noexcept;
+
+    // 0 to 1 for each cell of the density grid, log scaled, a row at a time with the top (right +1) first.
+    // Left goes from -1 on the left to +1 on the right.
+    const float* getDensity() const noexcept {
+        return density.data();
+    }
+
+private:
+    SampleOverview() = default;
+
+    // Each level is pairs of (min, max) for the left then the right channel, scaled to -127 to 127
+    std::vector<std::vector<juce::int8>> levels;
+    std::vector<float> density;
+    juce::int64 numFrames = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleOverview)
+};
@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    SampleOverviewDisplay.cpp
+    Created: 17 Oct 2026 5:58:12pm
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "SampleOverviewDisplay.h"
+
+//==============================================================================
+void SampleOverviewDisplay::setOverview(std::shared_ptr<const SampleOverview> newOverview) {
+    if (newOverview == overview) return;
+    overview = std::move(newOverview);
+    densityImage = juce::Image();
+
+    if (overview != nullptr) {
+        constexpr int size = SampleOverview::densitySize;
+        densityImage = juce::Image(juce::Image::ARGB, size, size, true);
+        juce::Image::BitmapData pixels(densityImage, juce::Image::BitmapData::writeOnly);
+        const float* density = overview->getDensity();
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                pixels.setPixelColour(x, y, juce::Colours::white.withAlpha(density[y * size + x]));
+            }
+        }
+    }
+    repaint();
+}
+
+void SampleOverviewDisplay::paint(juce::Graphics& g) {
+    auto bounds = getLocalBounds();
+    g.setColour(juce::Colours::black);
+    g.fillRect(bounds);
+    g.setColour(getLookAndFeel().findColour(juce::Label::textColourId));
+    g.drawRect(bounds);
+    if (overview == nullptr) return;
+
+    // XY on the right, as tall as we are
+    auto xyArea = bounds.removeFromRight(bounds.getHeight()).reduced(1);
+    g.drawImage(densityImage, xyArea.toFloat());
+
+    // Left channel on top, right below. Every column is one lookup in the pyramid.
+    auto waveArea = bounds.reduced(1);
+    int width = waveArea.getWidth();
+    float halfHeight = waveArea.getHeight() / 4.0f;
+    juce::int64 numFrames = overview->getNumFrames();
+    g.setColour(juce::Colour::fromRGB(90, 170, 230));
+    for (int c = 0; c < 2; c++) {
+        float centre = waveArea.getY() + halfHeight * float(c * 2 + 1);
+        for (int x = 0; x < width; x++) {
+            auto range = overview->getRange(c, numFrames * x / width, numFrames * (x + 1) / width);
+            float top = centre - range.getEnd() * halfHeight;
+            float bottom = juce::jmax(top + 1.0f, centre - range.getStart() * halfHeight);
+            g.drawVerticalLine(waveArea.getX() + x, top, bottom);
+        }
+    }
+}
@@ -0,0 +1,36 @@
+/*
+  ==============================================================================
+
+    SampleOverviewDisplay.h
+    Created: 17 Oct 2026 5:58:12pm
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "SampleOverview.h"
+
+//==============================================================================
+/*
+    Shows a slot's SampleOverview, the waveform of both channels on the left and
+    the XY density on the right. Painting only ever reads the overview.
+*/
+class SampleOverviewDisplay : public juce::Component
+{
+public:
+    SampleOverviewDisplay() = default;
+
+    // Null shows nothing
+    void setOverview(std::shared_ptr<const SampleOverview> newOverview);
+
+    void paint(juce::Graphics& g) override;
+
+private:
+    std::shared_ptr<const SampleOverview> overview;
+    // Made once per overview, not every paint
+    juce::Image densityImage;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleOverviewDisplay)
+};
@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    SamplePool.cpp
+    Created: 17 Oct 2026 2:41:07pm
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "SamplePool.h"
+
+//==============================================================================
+SamplePool::Ptr SamplePool::getOrCreate(const juce::File& file, bool compact, std::function<Ptr()> create, std::function<bool()> shouldGiveUp) {
+    const juce::String key = getKey(file, compact);
+
+    for (;;) {
+        std::shared_ptr<juce::WaitableEvent> waitFor;
+        std::shared_ptr<juce::WaitableEvent> mine;
+        {
+            const juce::ScopedLock sl(lock);
+            Entry& entry = entries[key];
+            if (Ptr data = entry.data.lock()) return data;
+
+            if (entry.loading != nullptr) waitFor = entry.loading;
+            else {
+                removeExpired();
+                mine = std::make_shared<juce::WaitableEvent>(true);
+                entries[key].loading = mine;
+            }
+        }
+
+        if (mine != nullptr) {
+            Ptr data = create();
+            {
+                const juce::ScopedLock sl(lock);
+                Entry& entry = entries[key];
+                entry.data = data;
+                entry.loading.reset();
+            }
+            mine->signal();
+            return data;
+        }
+
+        // Somebody else is on it, go around again once they're done
+        while (waitFor->wait(waitInterval) == false) {
+            if (shouldGiveUp()) return nullptr;
+        }
+    }
+}
+
+int SamplePool::getNumEntries() {
+    const juce::ScopedLock sl(lock);
+    removeExpired();
+    return int(entries.size());
+}
+
+// A file that's been changed on disk gets a new key, so it's loaded fresh instead of sharing the old version
+juce::String SamplePool::getKey(const juce::File& file, bool compact) {
+    return file.getFullPathName() + "|" + juce::String(file.getSize()) + "|" + juce::String(file.getLastModificationTime().toMilliseconds()) + (compact ? "|16" : "");
+}
+
+// Call with the lock held
+void SamplePool::removeExpired() {
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.loading == nullptr && it->second.data.expired()) it = entries.erase(it);
+        else it++;
+    }
+}
@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    SamplePool.h
+    Created: 17 Oct 2026 2:41:07pm
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "SampleData.h"
+
+//==============================================================================
+/*
+    Sample data shared by every S3 in the process. Files are keyed by their path,
+    size and modification time, so ten instances loading the same file decode it
+    once and hold one copy, and whoever asks while it's still being decoded just
+    waits for that instead of starting their own.
+
+    The pool only keeps weak references, the data goes away when the last slot
+    using it lets go. Get it with a juce::SharedResourcePointer<SamplePool>.
+*/
+class SamplePool
+{
+public:
+    using Ptr = std::shared_ptr<const SampleData>;
+
+    SamplePool() = default;
+
+    // Returns the data for file, calling create to make it if nobody has it. If another thread is already
+    // making it, waits for that one instead, and only calls create itself if that one came back empty.
+    // Returns null if create did, or if shouldGiveUp() said so while waiting. Compact (16 bit) and full
+    // precision copies of a file are kept apart.
+    Ptr getOrCreate(const juce::File& file, bool compact, std::function<Ptr()> create, std::function<bool()> shouldGiveUp);
+
+    // Number of files currently shared
+    int getNumEntries();
+
+private:
+    struct Entry {
+        std::weak_ptr<const SampleData> data;
+        // Set while somebody is creating the data, signalled when they're done
+        std::shared_ptr<juce::WaitableEvent> loading;
+    };
+
+    static juce::String getKey(const juce::File& file, bool compact);
+    void removeExpired();
+
+    // How often (ms) a waiting load checks whether it should give up
+    static constexpr int waitInterval = 50;
+
+    juce::CriticalSection lock;
+    std::map<juce::String, Entry> entries;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SamplePool)
+};
@@ -0,0 +1,157 @@
+/*
+  ==============================================================================
+
+    SampleStreamer.cpp
+    Created: 17 Oct 2026 11:20:51am
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "SampleStreamer.h"
+
+//==============================================================================
+StreamingSampleData::StreamingSampleData(std::unique_ptr<juce::AudioFormatReader> reader, std::unique_ptr<juce::AudioBuffer<float>> head, SampleStreamer& streamer)
+    : SampleData(reader->lengthInSamples, head->getNumChannels(), reader->sampleRate), reader(std::move(reader)), head(std::move(head)),
+      ring(numChannels, ringFrames), staging(numChannels, chunkFrames), streamer(streamer)
+{
+    jassert(this->head->getNumSamples() == headFrames);
+    streamer.add(this);
+}
+
+StreamingSampleData::~StreamingSampleData()
+{
+    // Blocks until the streamer is done with us if it's in the middle of a fill
+    streamer.remove(this);
+}
+
+void StreamingSampleData::getFrames(juce::int64 start, int num, const float** dest, float* const* scratch) const noexcept {
+    readPosition.store(start);
+
+    // All in the head, no copying needed
+    if (start + num <= headFrames) {
+        for (int c = 0; c < numChannels; c++) dest[c] = head->getReadPointer(c, int(start));
+        return;
+    }
+
+    for (int c = 0; c < numChannels; c++) dest[c] = scratch[c];
+
+    int done = 0;
+    if (start < headFrames) {
+        done = int(headFrames - start);
+        for (int c = 0; c < numChannels; c++) {
+            juce::FloatVectorOperations::copy(scratch[c], head->getReadPointer(c, int(start)), done);
+        }
+    }
+
+    juce::int64 from = start + done;
+    int count = num - done;
+    // Start before end, see fill() for why
+    int restart = restarts.load();
+    juce::int64 windowFrom = windowStart.load();
+    juce::int64 ahead = windowEnd.load() - from;
+    int available = 0;
+    if (from >= windowFrom && ahead > 0) {
+        available = int(juce::jmin(ahead, juce::int64(count)));
+        copyFromRing(from, available, scratch, done);
+
+        // If the streamer restarted or moved past us while we were copying, we can't trust any of it
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (restarts.load() != restart || windowStart.load() > from) available = 0;
+    }
+
+    if (available < count) {
+        for (int c = 0; c < numChannels; c++) {
+            juce::FloatVectorOperations::clear(scratch[c] + done + available, count - available);
+        }
+        underruns++;
+    }
+}
+
+void StreamingSampleData::copyFromRing(juce::int64 start, int num, float* const* dest, int destOffset) const noexcept {
+    int ringStart = int(start & ringMask);
+    int first = juce::jmin(num, ringFrames - ringStart);
+    for (int c = 0; c < numChannels; c++) {
+        juce::FloatVectorOperations::copy(dest[c] + destOffset, ring.getReadPointer(c, ringStart), first);
+        if (num > first) juce::FloatVectorOperations::copy(dest[c] + destOffset + first, ring.getReadPointer(c, 0), num - first);
+    }
+}
+
+bool StreamingSampleData::fill() {
+    // While the reader is in the head we want the ring to pick up right where the head ends
+    juce::int64 pos = juce::jmax(readPosition.load(), juce::int64(headFrames));
+    juce::int64 start = windowStart.load();
+    juce::int64 end = windowEnd.load();
+
+    if (pos < start || pos > end) {
+        // The reader jumped somewhere we don't have, start over from there. End moves first so
+        // a reader can never see the new start with the old end.
+        restarts++;
+        windowEnd.store(pos);
+        windowStart.store(pos);
+        start = end = pos;
+    }
+
+    // Don't get more than a whole ring ahead of the reader
+    int num = int(juce::jmin(juce::int64(chunkFrames), numFrames - end, pos + ringFrames - end));
+    if (num <= 0) return false;
+
+    {
+        S3_TRACE(streamer.telemetry, "Stream read", streamerTrack, num);
+        if (reader->read(staging.getArrayOfWritePointers(), numChannels, end, num) == false) {
+            staging.clear(0, num);
+        }
+    }
+
+    juce::int64 newStart = juce::jmax(start, end + num - ringFrames);
+    if (newStart > start) {
+        windowStart.store(newStart);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    int ringStart = int(end & ringMask);
+    int first = juce::jmin(num, ringFrames - ringStart);
+    for (int c = 0; c < numChannels; c++) {
+        ring.copyFrom(c, ringStart, staging, c, 0, first);
+        if (num > first) ring.copyFrom(c, 0, staging, c, first, num - first);
+    }
+
+    windowEnd.store(end + num);
+    return true;
+}
+
+//==============================================================================
+SampleStreamer::SampleStreamer()
+    : juce::Thread("S3 Sample Streamer")
+{
+    startThread(juce::Thread::Priority::high);
+}
+
+SampleStreamer::~SampleStreamer()
+{
+    stopThread(4000);
+}
+
+void SampleStreamer::add(StreamingSampleData* stream) {
+    const juce::ScopedLock lock(streamLock);
+    streams.add(stream);
+}
+
+void SampleStreamer::remove(StreamingSampleData* stream) {
+    const juce::ScopedLock lock(streamLock);
+    streams.removeFirstMatchingValue(stream);
+}
+
+void SampleStreamer::run() {
+    while (!threadShouldExit()) {
+        bool busy = false;
+        for (int i = 0;; i++) {
+            // Only hold the lock for one stream at a time so removing one never waits long
+            const juce::ScopedLock lock(streamLock);
+            if (i >= streams.size()) break;
+            busy = streams.getUnchecked(i)->fill() || busy;
+        }
+        if (!busy) wait(idleInterval);
+    }
+}
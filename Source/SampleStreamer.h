@@ -0,0 +1,126 @@
+/*
+  ==============================================================================
+
+    SampleStreamer.h
+    Created: 17 Oct 2026 11:20:51am
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "SampleData.h"
+#include "Telemetry.h"
+
+class SampleStreamer;
+
+//==============================================================================
+/*
+    A sample that's played straight off the disk. Only the head of the file is
+    kept in memory, the rest goes through a ring buffer that the streamer
+    thread keeps topped up ahead of wherever the audio thread is reading.
+
+    Looping always jumps back into the head, so the start of the loop is
+    already there while the ring refills from the end of the head.
+
+    Ring protocol: the ring holds frames [windowStart, windowEnd), frame f in
+    ring slot f & ringMask. The streamer only appends past windowEnd, and moves
+    windowStart up before it overwrites anything, so a reader that finds
+    windowStart still at or below what it copied knows the copy is good. When
+    the reader jumps somewhere the ring doesn't cover, the streamer bumps the
+    restart count (which invalidates any copy in flight) and begins a fresh
+    window there.
+*/
+class StreamingSampleData : public SampleData
+{
+public:
+    StreamingSampleData(std::unique_ptr<juce::AudioFormatReader> reader, std::unique_ptr<juce::AudioBuffer<float>> head, SampleStreamer& streamer);
+    ~StreamingSampleData() override;
+
+    void getFrames(juce::int64 start, int num, const float** dest, float* const* scratch) const noexcept override;
+
+    // There's one ring following one reader, a second one somewhere else would keep restarting it
+    bool isSingleReader() const noexcept override {
+        return true;
+    }
+
+    // Only the head is ever in memory for sure
+    void getRegions(juce::int64 start, juce::int64 num, std::vector<Region>& regions) const override {
+        if (clipFrames(start, num) == false || start >= headFrames) return;
+        int inHead = int(juce::jmin(num, juce::int64(headFrames) - start));
+        for (int c = 0; c < numChannels; c++) {
+            regions.push_back({ head->getReadPointer(c, int(start)), size_t(inHead) * sizeof(float) });
+        }
+    }
+
+    // Streamer thread. Reads at most one chunk, returns false if there was nothing to do.
+    bool fill();
+
+    int getUnderruns() const {
+        return underruns;
+    }
+
+    // Frames of the file that stay in memory
+    static constexpr int headFrames = 1 << 17;
+    // Frames the read-ahead ring can hold, must be a power of two
+    static constexpr int ringFrames = 1 << 18;
+    // Frames read from the disk in one go
+    static constexpr int chunkFrames = 1 << 14;
+
+private:
+    void copyFromRing(juce::int64 start, int num, float* const* dest, int destOffset) const noexcept;
+
+    static constexpr int ringMask = ringFrames - 1;
+
+    const std::unique_ptr<juce::AudioFormatReader> reader;
+    const std::unique_ptr<juce::AudioBuffer<float>> head;
+    juce::AudioBuffer<float> ring;
+    juce::AudioBuffer<float> staging;
+    SampleStreamer& streamer;
+
+    std::atomic<juce::int64> windowStart{ headFrames };
+    std::atomic<juce::int64> windowEnd{ headFrames };
+    std::atomic<int> restarts{ 0 };
+    mutable std::atomic<juce::int64> readPosition{ 0 };
+    mutable std::atomic<int> underruns{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StreamingSampleData)
+};
+
+//==============================================================================
+/*
+    The read-ahead thread that keeps every StreamingSampleData's ring full.
+*/
+class SampleStreamer : private juce::Thread
+{
+public:
+    SampleStreamer();
+    ~SampleStreamer() override;
+
+   #if S3_TELEMETRY
+    void setTelemetry(Telemetry* newTelemetry) {
+        telemetry = newTelemetry;
+    }
+   #endif
+
+private:
+    friend class StreamingSampleData;
+
+    void add(StreamingSampleData* stream);
+    void remove(StreamingSampleData* stream);
+
+    void run() override;
+
+    // How long (ms) to sleep when every ring is already full
+    static constexpr int idleInterval = 5;
+
+    juce::CriticalSection streamLock;
+    juce::Array<StreamingSampleData*> streams;
+
+   #if S3_TELEMETRY
+    std::atomic<Telemetry*> telemetry{ nullptr };
+   #endif
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SampleStreamer)
+};
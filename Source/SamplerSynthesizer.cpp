@@ -14,209 +14,777 @@
 //==============================================================================
 SamplerSynthesizer::SamplerSynthesizer()
 {
-    manager.registerBasicFormats();
-    for (int i = 0; i < MAX_SAMPLES; i++) {
-        samples[i] = SampleSlot();
-    }
 }
 
 SamplerSynthesizer::~SamplerSynthesizer()
 {
-    for (int i = 0; i < MAX_SAMPLES; i++) {
-        if (samples[i].buffer != nullptr) {
-            delete samples[i].buffer;
-        }
-    }
+    // Make sure nothing gets published while we're tearing down
+    loader.stop();
+    const juce::ScopedLock lock(slotLock);
+    samples.forEachAllocated([this](int, SampleSlot& slot) { retireSample(slot); });
 }
 
-void SamplerSynthesizer::processBlock(juce::AudioBuffer<float>& buffer, int beginSample, int endSample) {
-    if (waitingForOuterReset) {
-        time = 0;
-        waitingForOuterReset = false;
+bool SamplerSynthesizer::post(const SynthCommand& command) {
+    if (commands.push(command) == false) return false;
+    if (command.type == SynthCommand::chooseSample && command.part >= 0 && command.part < MAX_PARTS
+        && command.value >= 0 && command.value < MAX_SAMPLES) {
+        parts[command.part].selectedSample = command.value;
     }
+    return true;
+}
 
-    for (int i = 0; i < MAX_SAMPLES; i++) {
-        if (samples[i].waitingForReset) {
-            frequency = targetFrequency * frequencyFactor;
-            sourceFrequency = targetFrequency;
-            samples[i].sampleTime = 0;
-            samples[i].waitingForReset = false;
+void SamplerSynthesizer::beginBlock(int numSamples) {
+    numBlockCommands = 0;
+    nextBlockCommand = 0;
+
+    SynthCommand command;
+    while (numBlockCommands < maxCommands && commands.pop(command)) {
+        command.offset = juce::jlimit(0, juce::jmax(0, numSamples - 1), command.offset);
+        // Nearly always already in order, and this keeps commands for the same sample in the order they came
+        int i = numBlockCommands++;
+        while (i > 0 && blockCommands[i - 1].offset > command.offset) {
+            blockCommands[i] = blockCommands[i - 1];
+            i--;
         }
+        blockCommands[i] = command;
+    }
+
+    // Nothing's getting rendered, so nothing's going to get to them
+    if (numSamples <= 0) {
+        while (nextBlockCommand < numBlockCommands) applyCommand(blockCommands[nextBlockCommand++]);
     }
+    // The ones for the first sample go now, before the caller starts on the block's events
+    while (nextBlockCommand < numBlockCommands && blockCommands[nextBlockCommand].offset <= 0) {
+        applyCommand(blockCommands[nextBlockCommand++]);
+    }
+}
 
-    // If the current sample is invalid, gtfo
-    if (currentSample < 0 || currentSample >= MAX_SAMPLES) {
-        for (int i = beginSample; i < endSample; i++) {
-            buffer.setSample(0, i, 0);
-            buffer.setSample(1, i, 0);
+void SamplerSynthesizer::processBlock(juce::AudioBuffer<float>* buses, int numBuses, int beginSample, int endSample) {
+    // Keeps any sample data we look at alive until the end of this call
+    const EpochReclaimer<SampleData>::ReadScope readScope(reclaimer);
+
+    // Render up to each command, then apply it
+    while (beginSample < endSample) {
+        while (nextBlockCommand < numBlockCommands && blockCommands[nextBlockCommand].offset <= beginSample) {
+            applyCommand(blockCommands[nextBlockCommand++]);
         }
+        int until = endSample;
+        if (nextBlockCommand < numBlockCommands) until = juce::jmin(endSample, blockCommands[nextBlockCommand].offset);
+        renderBlock(buses, numBuses, beginSample, until);
+        beginSample = until;
+    }
+}
+
+void SamplerSynthesizer::applyCommand(const SynthCommand& command) {
+    switch (command.type) {
+    case SynthCommand::chooseSample:
+        chooseSample(command.value, command.part);
+        break;
+    case SynthCommand::reset:
+        if (command.part < 0) reset();
+        else resetPart(command.part);
+        break;
+    case SynthCommand::resetAll:
+        if (command.part < 0) resetAllSamples();
+        else resetAllSamples(command.part);
+        break;
+    case SynthCommand::allNotesOff:
+        noteOff();
+        break;
+    case SynthCommand::transpose:
+        transpose(command.value, command.amount);
+        break;
+    case SynthCommand::frequencyFactor:
+        setFrequencyFactor(command.amount);
+        break;
+    case SynthCommand::tuning:
+        setTuning(command.value);
+        break;
+    case SynthCommand::polyphony:
+        setPolyphony(command.value);
+        break;
+    case SynthCommand::voiceStealing:
+        setVoiceStealing(VoiceStealing(command.value));
+        break;
+    case SynthCommand::multiTimbral:
+        setMultiTimbral(command.value != 0);
+        break;
+    case SynthCommand::bus:
+        setPartBus(command.part, command.value);
+        break;
+    case SynthCommand::pitchBend:
+        setPitchBend(float(command.amount), command.part);
+        break;
+    default:
+        break;
+    }
+}
+
+void SamplerSynthesizer::renderBlock(juce::AudioBuffer<float>* buses, int numBuses, int beginSample, int endSample) {
+    bool written[MAX_BUSES] = {};
+    renderCount++;
+    int numParts = multiTimbral ? MAX_PARTS : 1;
+    for (int p = 0; p < numParts; p++) {
+        renderPart(buses, numBuses, written, beginSample, endSample, parts[p]);
+    }
+
+    // Nothing played into these
+    for (int b = 0; b < numBuses; b++) {
+        if (written[b] == false) buses[b].clear(beginSample, endSample - beginSample);
+    }
+}
+
+// Plays one part into whichever bus its slot goes to
+void SamplerSynthesizer::renderPart(juce::AudioBuffer<float>* buses, int numBuses, bool* written, int beginSample, int endSample, SamplerPart& part) {
+    if (part.waitingForOuterReset) {
+        part.phase = 0;
+        part.waitingForOuterReset = false;
+    }
+
+    if (numVoices > 1) {
+        renderVoices(buses, numBuses, written, beginSample, endSample, part);
+        part.lastPB = part.pitchBend;
         return;
     }
 
-    // If there's no sample loaded, or if we're not playing right now, gtfo
-    if ((samples[currentSample].loaded == false) || (playing == false)) {
-        for (int i = beginSample; i < endSample; i++) {
-            buffer.setSample(0, i, 0);
-            buffer.setSample(1, i, 0);
+    // If the current sample is invalid (or was never used), gtfo
+    SampleSlot* slot = samples.find(part.currentSample);
+    if (slot == nullptr) return;
+
+    // If there's no sample loaded (or it's still loading), or if we're not playing right now, gtfo
+    int p = getPartIndex(part);
+    const SampleData* data = slot->data.load();
+    if ((data == nullptr) || (part.playing == false)) return;
+
+    // Something else asked for a reset, stay quiet until it happens
+    if (slot->waitingForReset[p] == false && claimReader(*slot, data, p)) {
+        int b = getBus(buses, numBuses, part, *slot);
+        if (renderVoice(buses[b], beginSample, endSample, part, *slot, data, part.frequency, part.phase, written[b]) == false) {
+            slot->waitingForReset[p] = true;
         }
-        return;
+        written[b] = true;
     }
+    part.lastPB = part.pitchBend;
+}
 
-    int sampleNow = beginSample;
-    while (sampleNow < endSample) {
-        for (int c = 0; c < 2; c++) {
-            // Calculate sample value
-            int index = int(time);
-            if (index < samples[currentSample].buffer->getNumSamples() && samples[currentSample].waitingForReset == false) {
-                float sampleHere = samples[currentSample].buffer->getSample(c, index);
-                float sampleNext = samples[currentSample].buffer->getSample(c, (index + 1) % samples[currentSample].buffer->getNumSamples());
+// Polyphonic mode, every active voice gets mixed into its bus
+void SamplerSynthesizer::renderVoices(juce::AudioBuffer<float>* buses, int numBuses, bool* written, int beginSample, int endSample, SamplerPart& part) {
+    for (int v = 0; v < numVoices; v++) {
+        if (part.voiceActive[v] == false) continue;
+        SampleSlot* slot = samples.find(part.voiceSlot[v]);
+        if (slot == nullptr) continue;
+        const SampleData* data = slot->data.load();
+        if (data == nullptr) continue;
 
-                buffer.setSample(c, sampleNow, lerp_f(sampleHere, sampleNext, float(time - index)));
+        // Only the newest voice on a streamed slot plays it, a new note takes over from the old one
+        if (data->isSingleReader()) {
+            bool newer = false;
+            for (int w = 0; w < numVoices; w++) {
+                if (part.voiceActive[w] && part.voiceSlot[w] == part.voiceSlot[v] && part.voiceAge[w] > part.voiceAge[v]) newer = true;
             }
-            else {
-                buffer.setSample(c, sampleNow, 0);
+            if (newer) {
+                part.voiceActive[v] = false;
+                continue;
             }
+            if (claimReader(*slot, data, getPartIndex(part)) == false) continue;
+        }
+
+        int b = getBus(buses, numBuses, part, *slot);
+        if (renderVoice(buses[b], beginSample, endSample, part, *slot, data, part.voiceFrequency[v] * frequencyFactor, part.voicePhase[v], written[b]) == false) {
+            part.voiceActive[v] = false;
+        }
+        written[b] = true;
+    }
+}
+
+// Plays data from phase, either replacing what's in the buffer or mixing into it. Returns false if it's a
+// one-shot that ran out, the rest of the block is left silent then.
+bool SamplerSynthesizer::renderVoice(juce::AudioBuffer<float>& buffer, int beginSample, int endSample, const SamplerPart& part, const SampleSlot& slot, const SampleData* data, double frequency, juce::uint64& phase, bool mix) {
+    // Everything but the pitch bend stays put for the whole call, so work the increment out once.
+    // The bend ramps linearly from lastPB to pitchBend, so that's just a constant added every frame.
+    double baseIncrement = tuning * part.fineTuning * data->getSampleRate() / slot.rootFrequency * frequency / sampleRate * phaseOne;
+    Segment segment;
+    segment.data = data;
+    segment.numFrames = data->getNumFrames();
+    segment.increment = juce::int64(std::llround(baseIncrement * part.lastPB));
+    segment.delta = juce::int64(std::llround(baseIncrement * (part.pitchBend - part.lastPB) / juce::jmax(1, endSample - beginSample)));
+    segment.endSample = endSample;
+    segment.mix = mix;
+
+    // Every channel plays into the output with the same number, a mono sample into the first two
+    segment.numChannels = juce::jmin(data->getNumChannels(), buffer.getNumChannels());
+    segment.broadcast = data->getNumChannels() == 1 && buffer.getNumChannels() > 1;
+    segment.numOutputs = segment.broadcast ? 2 : segment.numChannels;
+    if (mix == false) {
+        for (int c = segment.numOutputs; c < buffer.getNumChannels(); c++) buffer.clear(c, beginSample, endSample - beginSample);
+    }
+
+    // Pick the kernel now so nothing inside the loops has to ask again
+    Kernel kernel = Kernel::fractional;
+    if (segment.delta != 0) kernel = Kernel::bend;
+    else if (segment.increment == juce::int64(1) << 32) kernel = Kernel::unity;
+    else if (segment.increment > 0 && (segment.increment & 0xffffffff) == 0) kernel = Kernel::integer;
+
+    switch (kernel) {
+    case Kernel::unity:
+        return slot.loop ? renderSegment<Kernel::unity, true>(buffer, beginSample, segment, phase)
+                         : renderSegment<Kernel::unity, false>(buffer, beginSample, segment, phase);
+    case Kernel::integer:
+        return slot.loop ? renderSegment<Kernel::integer, true>(buffer, beginSample, segment, phase)
+                         : renderSegment<Kernel::integer, false>(buffer, beginSample, segment, phase);
+    case Kernel::fractional:
+        return slot.loop ? renderSegment<Kernel::fractional, true>(buffer, beginSample, segment, phase)
+                         : renderSegment<Kernel::fractional, false>(buffer, beginSample, segment, phase);
+    default:
+        return slot.loop ? renderSegment<Kernel::bend, true>(buffer, beginSample, segment, phase)
+                         : renderSegment<Kernel::bend, false>(buffer, beginSample, segment, phase);
+    }
+}
+
+// The rest of renderVoice, from sampleNow to the end of the segment
+template <SamplerSynthesizer::Kernel kernel, bool loop>
+bool SamplerSynthesizer::renderSegment(juce::AudioBuffer<float>& buffer, int sampleNow, Segment& segment, juce::uint64& phase) {
+    while (sampleNow < segment.endSample) {
+        int done = renderRun<kernel>(buffer, sampleNow, segment, phase);
+        if (done == 0) {
+            // The last frame of the sample wraps around, do it the slow way
+            renderFrame(buffer, sampleNow, segment, phase);
+            phase += juce::uint64(segment.increment);
+            if constexpr (kernel == Kernel::bend) segment.increment += segment.delta;
+            done = 1;
         }
-        // Increment time
-        double actualPB = lerp_f(lastPB, pitchBend, (sampleNow - beginSample) / float(endSample - beginSample));
-        double increment = tuning * samples[currentSample].rootSampleRate / samples[currentSample].rootFrequency * frequency / sampleRate * actualPB;
-        time = time + increment;
-        sampleNow++;
-        
+        sampleNow += done;
+
         // If we've hit the end of the sample:
-        if (int(time) >= samples[currentSample].buffer->getNumSamples()) {
+        if (juce::int64(phase >> 32) >= segment.numFrames) {
             // Loop if we're supposed to
-            if (samples[currentSample].loop) {
-                time = time - samples[currentSample].buffer->getNumSamples();
+            if constexpr (loop) {
+                phase -= juce::uint64(segment.numFrames) << 32;
             }
             // Otherwise gtfo
             else {
-                samples[currentSample].waitingForReset = true;
-                while (sampleNow < endSample) {
-                    buffer.setSample(0, sampleNow, 0);
-                    buffer.setSample(1, sampleNow, 0);
-                    sampleNow++;
-                }
+                if (segment.mix == false) buffer.clear(sampleNow, segment.endSample - sampleNow);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Renders as many frames as it can in one go, returns how many that was. Stops before the last frame
+// of the sample (that one needs the first frame too), and when time runs off the end of the sample.
+template <SamplerSynthesizer::Kernel kernel>
+int SamplerSynthesizer::renderRun(juce::AudioBuffer<float>& buffer, int sampleNow, Segment& segment, juce::uint64& phase) {
+    juce::int64 first = juce::int64(phase >> 32);
+    juce::uint32 fraction = juce::uint32(phase);
+    const float* window[SampleData::maxChannels];
+
+    // On a whole frame at the sample's own speed, the frames go straight into the buffer
+    if constexpr (kernel == Kernel::unity) {
+        if (fraction == 0) {
+            int n = int(juce::jmin(juce::int64(juce::jmin(segment.endSample - sampleNow, scratchFrames)), segment.numFrames - first));
+            if (n <= 0) return 0;
+            segment.data->getFrames(first, n, window, scratch.getArrayOfWritePointers());
+            for (int c = 0; c < segment.numOutputs; c++) {
+                const float* source = window[segment.broadcast ? 0 : c];
+                if (segment.mix) juce::FloatVectorOperations::add(buffer.getWritePointer(c, sampleNow), source, n);
+                else juce::FloatVectorOperations::copy(buffer.getWritePointer(c, sampleNow), source, n);
+            }
+            phase += juce::uint64(n) << 32;
+            return n;
+        }
+    }
+
+    int maxFrames = juce::jmin(segment.endSample - sampleNow, kernelFrames);
+    int n = 0;
+    int step = 1;
+
+    if constexpr (kernel == Kernel::unity || kernel == Kernel::integer) {
+        // Every frame is the same distance between two frames, step apart
+        step = int(segment.increment >> 32);
+        if (first + 1 >= segment.numFrames) return 0;
+        n = int(juce::jmin(juce::int64(juce::jmin(maxFrames, (scratchFrames - 2) / step + 1)), (segment.numFrames - 2 - first) / step + 1));
+        segment.data->getFrames(first, (n - 1) * step + 2, window, scratch.getArrayOfWritePointers());
+        phase += juce::uint64(segment.increment) * juce::uint64(n);
+    }
+    else {
+        // Work out where every frame reads from, relative to the first frame of the run
+        juce::uint64 p = phase;
+        juce::int64 increment = segment.increment;
+        while (n < maxFrames) {
+            juce::int64 index = juce::int64(p >> 32);
+            if (index + 1 >= segment.numFrames || index + 2 - first > scratchFrames) break;
+            runIndex[n] = int(index - first);
+            runFraction[n] = float(juce::uint32(p)) * float(1.0 / phaseOne);
+            p += juce::uint64(increment);
+            if constexpr (kernel == Kernel::bend) increment += segment.delta;
+            n++;
+            if (juce::int64(p >> 32) >= segment.numFrames) break;
+        }
+        if (n == 0) return 0;
+        segment.data->getFrames(first, runIndex[n - 1] + 2, window, scratch.getArrayOfWritePointers());
+        phase = p;
+        segment.increment = increment;
+    }
+
+    // Then gather the pairs of frames and interpolate the whole run at once. A mono sample only gets
+    // interpolated once, the second output is a copy.
+    for (int c = 0; c < segment.numChannels; c++) {
+        const float* here = window[c];
+        if constexpr (kernel == Kernel::unity) {
+            juce::FloatVectorOperations::subtract(runDelta, window[c] + 1, window[c], n);
+        }
+        else if constexpr (kernel == Kernel::integer) {
+            for (int i = 0; i < n; i++) {
+                runHere[i] = window[c][i * step];
+                runDelta[i] = window[c][i * step + 1];
+            }
+            juce::FloatVectorOperations::subtract(runDelta, runHere, n);
+            here = runHere;
+        }
+        else {
+            for (int i = 0; i < n; i++) {
+                runHere[i] = window[c][runIndex[i]];
+                runDelta[i] = window[c][runIndex[i] + 1];
             }
+            juce::FloatVectorOperations::subtract(runDelta, runHere, n);
+            here = runHere;
+        }
+
+        if constexpr (kernel == Kernel::unity || kernel == Kernel::integer) {
+            juce::FloatVectorOperations::multiply(runDelta, float(fraction) * float(1.0 / phaseOne), n);
+        }
+        else {
+            juce::FloatVectorOperations::multiply(runDelta, runFraction, n);
+        }
+
+        if (segment.mix) {
+            juce::FloatVectorOperations::add(runDelta, here, n);
+            juce::FloatVectorOperations::add(buffer.getWritePointer(c, sampleNow), runDelta, n);
+            if (segment.broadcast) juce::FloatVectorOperations::add(buffer.getWritePointer(1, sampleNow), runDelta, n);
         }
+        else {
+            juce::FloatVectorOperations::add(buffer.getWritePointer(c, sampleNow), here, runDelta, n);
+            if (segment.broadcast) juce::FloatVectorOperations::copy(buffer.getWritePointer(1, sampleNow), buffer.getReadPointer(c, sampleNow), n);
+        }
+    }
+    return n;
+}
+
+// Renders a single frame at the current time, wrapping around to the first frame if it has to
+void SamplerSynthesizer::renderFrame(juce::AudioBuffer<float>& buffer, int sampleNow, const Segment& segment, juce::uint64 phase) {
+    juce::int64 index = juce::int64(phase >> 32);
+    if (index >= segment.numFrames) {
+        if (segment.mix) return;
+        for (int c = 0; c < segment.numOutputs; c++) buffer.setSample(c, sampleNow, 0);
+        return;
+    }
+
+    float* hereScratch[SampleData::maxChannels];
+    float* nextScratch[SampleData::maxChannels];
+    for (int c = 0; c < SampleData::maxChannels; c++) {
+        hereScratch[c] = scratch.getWritePointer(c);
+        nextScratch[c] = scratch.getWritePointer(c, scratchFrames);
+    }
+    const float* here[SampleData::maxChannels];
+    const float* next[SampleData::maxChannels];
+    segment.data->getFrames(index, 1, here, hereScratch);
+    segment.data->getFrames((index + 1) % segment.numFrames, 1, next, nextScratch);
+
+    for (int c = 0; c < segment.numOutputs; c++) {
+        int source = segment.broadcast ? 0 : c;
+        float value = float(lerp_f(*here[source], *next[source], juce::uint32(phase) / phaseOne));
+        if (segment.mix) buffer.addSample(c, sampleNow, value);
+        else buffer.setSample(c, sampleNow, value);
     }
-     lastPB = pitchBend;
 }
 
-// Returns -1 if sample is occupied, -2 if sample position is out of bounds, -3 if file is invalid, -4 if file loading failed, otherwise returns position of loaded sample
-int SamplerSynthesizer::loadSample(juce::File audioFile, double rootFrequency, int samplePosition, bool loop) {
+// Returns -1 if sample is occupied, -2 if sample position is out of bounds, otherwise returns position of the reserved sample.
+// The file is decoded on the loader thread, failures are reported to the loader's listeners and free the slot again.
+int SamplerSynthesizer::loadSample(juce::File audioFile, double rootFrequency, int samplePosition, bool loop, bool stream) {
     if (samplePosition < 0 || samplePosition >= MAX_SAMPLES) return -2;
-    if (samples[samplePosition].loaded) return -1;
+    SampleSlot& slot = samples.get(samplePosition);
+    if (slot.loaded) return -1;
 
-    juce::AudioFormatReader* reader = manager.createReaderFor(audioFile);
-    if (reader == nullptr) return -3;
+    SampleLoadJob job;
+    {
+        const juce::ScopedLock lock(slotLock);
+        slot.filePath = audioFile.getFullPathName();
+        slot.fileName = audioFile.getFileName();
+        slot.loop = loop;
+        slot.rootFrequency = rootFrequency;
+        for (int p = 0; p < MAX_PARTS; p++) {
+            slot.samplePhase[p] = 0;
+        }
+        slot.loaded = true;
+        slot.loading = true;
+        slot.streaming = stream;
+        job.generation = ++slot.generation;
+    }
+    samples.setOccupied(samplePosition, true);
+
+    job.slot = samplePosition;
+    job.file = audioFile;
+    job.stream = stream;
+    job.compact = compactStorage;
+    loader.addJob(job);
+    return samplePosition;
+}
+
+// Loads the slot's file again in the other mode, returns false if there's nothing to change.
+// Whatever's in the slot now keeps playing until the new data is ready.
+bool SamplerSynthesizer::setSampleStreaming(int samplePosition, bool stream) {
+    SampleSlot* slot = samples.find(samplePosition);
+    if (slot == nullptr) return false;
+    if (slot->loaded == false || slot->streaming == stream) return false;
 
-    samples[samplePosition].filePath = audioFile.getFullPathName();
-    samples[samplePosition].fileName = audioFile.getFileName();
-    samples[samplePosition].loop = loop;
-    samples[samplePosition].rootFrequency = rootFrequency;
-    samples[samplePosition].rootSampleRate = reader->sampleRate;
-    samples[samplePosition].buffer = new juce::AudioBuffer<float>;
-    samples[samplePosition].sampleTime = 0;
-    samples[samplePosition].loaded = true;
-    samples[samplePosition].buffer->setSize(2, int(reader->lengthInSamples));
-    if (reader->read(samples[samplePosition].buffer, 0, int(reader->lengthInSamples), 0, true, true) == false) unloadSample(samplePosition);
-    else if (samples[samplePosition].buffer->getNumSamples() < 1) unloadSample(samplePosition);
-    recalculateNumSamples();
+    SampleLoadJob job;
+    {
+        const juce::ScopedLock lock(slotLock);
+        slot->loading = true;
+        slot->streaming = stream;
+        job.generation = ++slot->generation;
+        job.file = juce::File(slot->filePath);
+    }
 
-    delete reader;
+    job.slot = samplePosition;
+    job.stream = stream;
+    job.compact = compactStorage;
+    loader.addJob(job);
+    return true;
+}
 
-    if (samples[samplePosition].loaded == true) return samplePosition;
-    else return -4;
+bool SamplerSynthesizer::publishSample(int samplePosition, int generation, std::shared_ptr<const SampleData> data) {
+    const juce::ScopedLock lock(slotLock);
+    SampleSlot& slot = samples.get(samplePosition);
+    if (slot.generation != generation) return false;
+    slot.loading = false;
+    slot.data.store(data.get());
+    reclaimer.retire(std::exchange(slot.owner, std::move(data)));
+    return true;
+}
+
+std::shared_ptr<const SampleData> SamplerSynthesizer::getSampleData(int samplePosition, int generation) {
+    const juce::ScopedLock lock(slotLock);
+    SampleSlot* slot = samples.find(samplePosition);
+    if (slot == nullptr || slot->generation != generation) return nullptr;
+    return slot->owner;
+}
+
+bool SamplerSynthesizer::setSampleOverview(int samplePosition, int generation, std::shared_ptr<const SampleOverview> overview) {
+    const juce::ScopedLock lock(slotLock);
+    SampleSlot* slot = samples.find(samplePosition);
+    if (slot == nullptr || slot->generation != generation) return false;
+    slot->overview = std::move(overview);
+    return true;
+}
+
+void SamplerSynthesizer::retireSample(SampleSlot& slot) {
+    slot.data.store(nullptr);
+    reclaimer.retire(std::move(slot.owner));
+    slot.owner = nullptr;
+}
+
+void SamplerSynthesizer::abandonLoad(int samplePosition, int generation) {
+    SampleSlot& slot = samples.get(samplePosition);
+    if (slot.generation != generation) return;
+    {
+        // A reload that failed leaves the old data in place. It can't be retired while we hold the lock.
+        const juce::ScopedLock lock(slotLock);
+        const SampleData* data = slot.data.load();
+        if (data != nullptr) {
+            slot.loading = false;
+            slot.streaming = dynamic_cast<const StreamingSampleData*>(data) != nullptr;
+            return;
+        }
+    }
+    unloadSample(samplePosition);
 }
 
 // Returns true if a sample was deleted
 bool SamplerSynthesizer::unloadSample(int samplePosition) {
-    if (samplePosition < 0 || samplePosition >= MAX_SAMPLES) return false;
-    if (samples[samplePosition].loaded == false) return false;
-    samples[samplePosition].loaded = false;
-    delete(samples[samplePosition].buffer);
-    samples[samplePosition].buffer = nullptr;
-    samples[samplePosition].filePath = "";
-    samples[samplePosition].fileName = "Not Loaded";
-    recalculateNumSamples();
+    SampleSlot* slot = samples.find(samplePosition);
+    if (slot == nullptr || slot->loaded == false) return false;
+    {
+        const juce::ScopedLock lock(slotLock);
+        slot->generation++;
+        slot->loaded = false;
+        slot->loading = false;
+        slot->streaming = false;
+        slot->bus = -1;
+        retireSample(*slot);
+        slot->overview = nullptr;
+        slot->filePath = "";
+        slot->fileName = "Not Loaded";
+    }
+    samples.setOccupied(samplePosition, false);
+    reclaimer.collect();
     return true;
 }
 
 // Returns -1 if sample is out of bounds, otherwise returns position of current sample
-int SamplerSynthesizer::chooseSample(int samplePosition) {
+int SamplerSynthesizer::chooseSample(int samplePosition, int part) {
     if (samplePosition < 0 || samplePosition >= MAX_SAMPLES) return -1;
-    if (currentSample >= 0 && currentSample < MAX_SAMPLES && samples[currentSample].loaded) samples[currentSample].sampleTime = time;
-    currentSample = samplePosition;
-    time = samples[currentSample].sampleTime;
-    return currentSample;
+    SamplerPart& p = parts[part];
+    SampleSlot* slot = samples.find(p.currentSample);
+    if (slot != nullptr && slot->loaded) slot->samplePhase[part] = p.phase;
+    p.currentSample = samplePosition;
+    p.selectedSample = samplePosition;
+    slot = samples.find(p.currentSample);
+    p.phase = slot != nullptr ? slot->samplePhase[part].load() : 0;
+    return p.currentSample;
 }
 
-void SamplerSynthesizer::noteOn(int note) {
-    playing = true;
-    this->note = note;
-    sourceFrequency = targetFrequency;
-    targetFrequency = midiNoteNumberToFrequency(note);
-    frequency = targetFrequency * frequencyFactor;
-    if (samples[currentSample].waitingForReset) {
-        time = 0;
-        samples[currentSample].waitingForReset = false;
+void SamplerSynthesizer::noteOn(int note, int part) {
+    SamplerPart& p = parts[part];
+    if (numVoices > 1) {
+        startVoice(p, note);
+        return;
+    }
+    p.playing = true;
+    p.note = note;
+    p.sourceFrequency = p.targetFrequency;
+    p.targetFrequency = midiNoteNumberToFrequency(note);
+    p.frequency = p.targetFrequency * frequencyFactor;
+    SampleSlot* slot = samples.find(p.currentSample);
+    if (slot != nullptr && slot->waitingForReset[part]) {
+        p.phase = 0;
+        slot->waitingForReset[part] = false;
     }
 }
 
-void SamplerSynthesizer::noteOff(int note) {
-    if (note == this->note) playing = false;
+void SamplerSynthesizer::noteOff(int note, int part) {
+    SamplerPart& p = parts[part];
+    if (numVoices > 1) {
+        for (int v = 0; v < numVoices; v++) {
+            if (p.voiceNote[v] == note) p.voiceActive[v] = false;
+        }
+        return;
+    }
+    if (note == p.note) p.playing = false;
+}
+
+void SamplerSynthesizer::noteOff() {
+    for (SamplerPart& part : parts) {
+        part.playing = false;
+        for (int v = 0; v < MAX_VOICES; v++) {
+            part.voiceActive[v] = false;
+        }
+    }
+}
+
+// Anything above the new number of voices gets cut off. Going back to one voice goes back to the
+// monophonic behavior, where the current slot keeps its place between notes.
+void SamplerSynthesizer::setPolyphony(int voices) {
+    numVoices = juce::jlimit(1, MAX_VOICES, voices);
+    for (SamplerPart& part : parts) {
+        for (int v = numVoices; v < MAX_VOICES; v++) {
+            part.voiceActive[v] = false;
+        }
+        if (numVoices == 1) part.voiceActive[0] = false;
+    }
+}
+
+// Plays the part's current slot from the start on a free voice, or steals one if they're all busy
+bool SamplerSynthesizer::claimReader(SampleSlot& slot, const SampleData* data, int part) {
+    if (data->isSingleReader() == false) return true;
+    if (slot.readerPart >= 0 && slot.readerPart != part && slot.readerRender + 1 >= renderCount) return false;
+    slot.readerPart = part;
+    slot.readerRender = renderCount;
+    return true;
+}
+
+void SamplerSynthesizer::startVoice(SamplerPart& part, int note) {
+    if (part.currentSample < 0 || part.currentSample >= MAX_SAMPLES) return;
+
+    int voice = -1;
+    for (int v = 0; v < numVoices; v++) {
+        if (part.voiceActive[v] == false) {
+            voice = v;
+            break;
+        }
+    }
+    if (voice < 0) voice = findVoiceToSteal(part);
+    if (voice < 0) return;
+
+    part.voiceActive[voice] = true;
+    part.voiceNote[voice] = note;
+    part.voiceSlot[voice] = part.currentSample;
+    part.voicePhase[voice] = 0;
+    part.voiceFrequency[voice] = midiNoteNumberToFrequency(note);
+    part.voiceAge[voice] = ++nextVoiceAge;
+}
+
+// Returns -1 if the new note shouldn't steal anything
+int SamplerSynthesizer::findVoiceToSteal(const SamplerPart& part) {
+    if (voiceStealing == VoiceStealing::none) return -1;
+
+    int voice = 0;
+    for (int v = 1; v < numVoices; v++) {
+        switch (voiceStealing) {
+        case VoiceStealing::oldest:
+            if (part.voiceAge[v] < part.voiceAge[voice]) voice = v;
+            break;
+        case VoiceStealing::lowest:
+            if (part.voiceNote[v] < part.voiceNote[voice]) voice = v;
+            break;
+        case VoiceStealing::highest:
+            if (part.voiceNote[v] > part.voiceNote[voice]) voice = v;
+            break;
+        default:
+            break;
+        }
+    }
+    return voice;
+}
+
+// Back to the start, for the part's saved place in the slot and any of its voices playing it
+void SamplerSynthesizer::resetSlot(SamplerPart& part, int slotNum, SampleSlot& slot) {
+    int p = getPartIndex(part);
+    part.frequency = part.targetFrequency * frequencyFactor;
+    part.sourceFrequency = part.targetFrequency;
+    slot.samplePhase[p] = 0;
+    slot.waitingForReset[p] = false;
+    for (int v = 0; v < numVoices; v++) {
+        if (part.voiceSlot[v] == slotNum) part.voicePhase[v] = 0;
+    }
 }
 
 void SamplerSynthesizer::reset(int pos) {
-    samples[pos].waitingForReset = true;
+    SampleSlot* slot = samples.find(pos);
+    if (slot == nullptr) return;
+    for (SamplerPart& part : parts) {
+        resetSlot(part, pos, *slot);
+    }
+}
+
+void SamplerSynthesizer::reset() {
+    for (int p = 0; p < MAX_PARTS; p++) {
+        resetPart(p);
+    }
+}
+
+void SamplerSynthesizer::resetPart(int part) {
+    SamplerPart& p = parts[part];
+    if (SampleSlot* slot = samples.find(p.currentSample)) resetSlot(p, p.currentSample, *slot);
+    p.waitingForOuterReset = true;
+}
+
+// Only walks the pages that exist, so it's cheap enough for the audio thread
+void SamplerSynthesizer::resetAllSamples() {
+    samples.forEachAllocated([](int, SampleSlot& slot) {
+        for (int p = 0; p < MAX_PARTS; p++) {
+            slot.samplePhase[p] = 0;
+            slot.waitingForReset[p] = false;
+        }
+    });
+    for (SamplerPart& part : parts) {
+        part.frequency = part.targetFrequency * frequencyFactor;
+        part.sourceFrequency = part.targetFrequency;
+        for (int v = 0; v < numVoices; v++) {
+            part.voicePhase[v] = 0;
+        }
+        part.waitingForOuterReset = true;
+    }
+}
+
+void SamplerSynthesizer::resetAllSamples(int part) {
+    samples.forEachAllocated([part](int, SampleSlot& slot) {
+        slot.samplePhase[part] = 0;
+        slot.waitingForReset[part] = false;
+    });
+    SamplerPart& p = parts[part];
+    p.frequency = p.targetFrequency * frequencyFactor;
+    p.sourceFrequency = p.targetFrequency;
+    for (int v = 0; v < numVoices; v++) {
+        p.voicePhase[v] = 0;
+    }
+    p.waitingForOuterReset = true;
 }
 
-// This basically uses a linked list which I hate but I kinda have to do it
 void SamplerSynthesizer::getXmlState(juce::XmlElement* parent) {
     juce::XmlElement* main = parent->createNewChildElement("Synth");
-    main->setAttribute("waitingForOuterReset", waitingForOuterReset);
-    main->setAttribute("currentSample", currentSample);
-    juce::XmlElement* slot = main;
-    for (int i = 0; i < MAX_SAMPLES; i++) {
-        if (samples[i].loaded) {
-            slot = slot->createNewChildElement("Slot");
-            slot->setAttribute("slot", i);
-            slot->setAttribute("rootFrequency", samples[i].rootFrequency);
-            slot->setAttribute("loop", samples[i].loop);
-            slot->setAttribute("sampleTime", samples[i].sampleTime);
-            slot->setAttribute("filePath", samples[i].filePath);
-            slot->setAttribute("waitingForReset", samples[i].waitingForReset);
+    main->setAttribute("waitingForOuterReset", parts[0].waitingForOuterReset);
+    main->setAttribute("currentSample", parts[0].selectedSample.load());
+    main->setAttribute("residentNeighbours", residency.getNeighbours());
+    main->setAttribute("residentRecent", residency.getRecent());
+    main->setAttribute("bus", parts[0].bus.load());
+    // The rest of the parts only remember which slot they're on and where it goes
+    for (int p = 1; p < MAX_PARTS; p++) {
+        if (parts[p].selectedSample >= 0 || parts[p].bus != 0) {
+            juce::XmlElement* part = main->createNewChildElement("Part");
+            part->setAttribute("part", p);
+            part->setAttribute("currentSample", parts[p].selectedSample.load());
+            part->setAttribute("bus", parts[p].bus.load());
         }
     }
+    // One flat list, thousands of slots nested inside each other would blow the stack
+    juce::XmlElement* slots = main->createNewChildElement("Slots");
+    samples.forEachOccupied([this, slots](int i) {
+        const SampleSlot& sample = *samples.find(i);
+        juce::XmlElement* slot = slots->createNewChildElement("Slot");
+        slot->setAttribute("slot", i);
+        slot->setAttribute("rootFrequency", sample.rootFrequency.load());
+        slot->setAttribute("loop", sample.loop.load());
+        slot->setAttribute("sampleTime", sample.samplePhase[0].load() / phaseOne);
+        slot->setAttribute("filePath", sample.filePath);
+        slot->setAttribute("waitingForReset", sample.waitingForReset[0].load());
+        slot->setAttribute("stream", sample.streaming);
+        slot->setAttribute("bus", sample.bus.load());
+    });
 }
 
-void SamplerSynthesizer::loadXmlState(juce::XmlElement* state) {
+void SamplerSynthesizer::loadXmlState(juce::XmlElement* state, std::vector<SynthCommand>& partCommands) {
     if (state == nullptr) return;
-    waitingForOuterReset = state->getBoolAttribute("waitingForOuterReset", true);
-    currentSample = state->getIntAttribute("currentSample", 0);
-    juce::XmlElement* slot = state->getChildByName("Slot");
-    for (int i = 0; i < MAX_SAMPLES; i++) {
-        if (slot != nullptr) {
-            int slotNum = slot->getIntAttribute("slot", -1);
-            if (slotNum >= 0 && slotNum < MAX_SAMPLES) {
-                loadSample(juce::File(slot->getStringAttribute("filePath")), slot->getDoubleAttribute("rootFrequency"), slotNum, slot->getBoolAttribute("loop", true));
-                samples[slotNum].sampleTime = slot->getDoubleAttribute("sampleTime", 0);
-                samples[slotNum].waitingForReset = slot->getBoolAttribute("waitingForReset", true);
-            }
-            slot = slot->getChildByName("Slot");
+    residency.setNeighbours(state->getIntAttribute("residentNeighbours", residency.getNeighbours()));
+    residency.setRecent(state->getIntAttribute("residentRecent", residency.getRecent()));
+
+    if (juce::XmlElement* slots = state->getChildByName("Slots")) {
+        for (auto* slot : slots->getChildWithTagNameIterator("Slot")) {
+            loadXmlSlot(slot);
+        }
+    }
+    else {
+        // Older versions saved each slot inside the one before it
+        for (juce::XmlElement* slot = state->getChildByName("Slot"); slot != nullptr; slot = slot->getChildByName("Slot")) {
+            loadXmlSlot(slot);
         }
-        else break;
+    }
+
+    partCommands.push_back({ SynthCommand::chooseSample, state->getIntAttribute("currentSample", 0) });
+    if (state->getBoolAttribute("waitingForOuterReset", true)) partCommands.push_back({ SynthCommand::reset });
+    partCommands.push_back({ SynthCommand::bus, state->getIntAttribute("bus", 0) });
+    for (auto* part : state->getChildWithTagNameIterator("Part")) {
+        int p = part->getIntAttribute("part", -1);
+        if (p > 0 && p < MAX_PARTS) {
+            int currentSample = part->getIntAttribute("currentSample", -1);
+            if (currentSample >= 0) partCommands.push_back({ SynthCommand::chooseSample, currentSample, 0, p });
+            partCommands.push_back({ SynthCommand::bus, part->getIntAttribute("bus", 0), 0, p });
+        }
+    }
+}
+
+void SamplerSynthesizer::loadXmlSlot(juce::XmlElement* slot) {
+    int slotNum = slot->getIntAttribute("slot", -1);
+    if (slotNum < 0 || slotNum >= MAX_SAMPLES) return;
+    loadSample(juce::File(slot->getStringAttribute("filePath")), slot->getDoubleAttribute("rootFrequency"), slotNum, slot->getBoolAttribute("loop", true), slot->getBoolAttribute("stream", false));
+    SampleSlot& sample = samples.get(slotNum);
+    sample.bus = juce::jlimit(-1, MAX_BUSES - 1, slot->getIntAttribute("bus", -1));
+    // A slot that was waiting for a reset comes back already reset
+    if (slot->getBoolAttribute("waitingForReset", false) == false) {
+        sample.samplePhase[0] = juce::uint64(slot->getDoubleAttribute("sampleTime", 0) * phaseOne);
     }
 }
 
 void SamplerSynthesizer::transpose(int semitones, double cents) {
-    if (samples[currentSample].loaded) {
-        samples[currentSample].rootFrequency = samples[currentSample].rootFrequency * (std::pow(2.0, (semitones + (cents / 100.0)) / 12.0));
+    SampleSlot* slot = samples.find(parts[0].currentSample);
+    if (slot != nullptr && slot->loaded) {
+        slot->rootFrequency = slot->rootFrequency * (std::pow(2.0, (semitones + (cents / 100.0)) / 12.0));
     }
 }
 void SamplerSynthesizer::transpose(double newFrequency) {
-    if (samples[currentSample].loaded) {
-        samples[currentSample].rootFrequency = std::max(0.1, newFrequency);
+    SampleSlot* slot = samples.find(parts[0].currentSample);
+    if (slot != nullptr && slot->loaded) {
+        slot->rootFrequency = std::max(0.1, newFrequency);
     }
 }
\ No newline at end of file
@@ -10,23 +10,139 @@
 
 #pragma once
 #include <JuceHeader.h>
-
-#define MAX_SAMPLES 100
+#include "SampleLoader.h"
+#include "SampleData.h"
+#include "SampleOverview.h"
+#include "SampleStreamer.h"
+#include "EpochReclaimer.h"
+#include "SlotBank.h"
+#include "CommandQueue.h"
+#include "Telemetry.h"
+#include "ResidencyManager.h"
+
+#define MAX_SAMPLES 4096
+#define MAX_VOICES 16
+#define MAX_PARTS 16
+#define MAX_BUSES 8
+
+// Which voice a new note takes over when they're all playing
+enum class VoiceStealing {
+    oldest,
+    lowest,
+    highest,
+    none
+};
 
 struct SampleSlot {
-    juce::AudioBuffer<float>* buffer = nullptr;
-    double rootFrequency = 0;
-    double rootSampleRate = 192000;
-    bool loop = true;
+    SampleSlot() {
+        for (int i = 0; i < MAX_PARTS; i++) {
+            samplePhase[i] = 0;
+            waitingForReset[i] = false;
+        }
+    }
+
+    // Published by the loader thread once the whole file is decoded, null until then.
+    // The audio thread only touches it inside a ReadScope, see EpochReclaimer.
+    std::atomic<const SampleData*> data{ nullptr };
+    // Keeps data alive, it might be shared with other instances through the pool. Only touched under the slot lock.
+    std::shared_ptr<const SampleData> owner;
+    // Built by the loader after data, for the editor. Null until then, also only touched under the slot lock.
+    std::shared_ptr<const SampleOverview> overview;
+    // Bumped whenever the slot is (re)loaded or ejected so stale load jobs can tell they're stale
+    std::atomic<int> generation{ 0 };
+    std::atomic<double> rootFrequency{ 0 };
+    std::atomic<bool> loop{ true };
+    // Output bus the slot plays into, -1 for whichever one the part playing it is on
+    std::atomic<int> bus{ -1 };
+    // The message thread's view of the slot (reserved / still decoding), the audio thread only looks at data
     bool loaded = false;
-    bool waitingForReset = true;
-    double sampleTime = 0;
+    bool loading = false;
+    bool streaming = false;
     juce::String fileName = "Not Loaded";
     juce::String filePath = "";
+
+    // Per part, where it was when it last chose away from this slot (same units as SamplerPart::phase) and
+    // whether it's a one-shot that ran out, which stays quiet until the next note or reset. The residency
+    // manager reads samplePhase to know where to prefetch from.
+    std::atomic<juce::uint64> samplePhase[MAX_PARTS];
+    std::atomic<bool> waitingForReset[MAX_PARTS];
+
+    // Audio thread. Which part last read a single reader (streamed) slot and in which render call, see
+    // SamplerSynthesizer::claimReader().
+    int readerPart = -1;
+    juce::uint64 readerRender = 0;
 };
 
 //==============================================================================
 /*
+    Everything one MIDI channel plays with. Normally only the first part is
+    used, in multi-timbral mode every channel gets its own, all of them playing
+    from the synth's one set of slots.
+*/
+struct SamplerPart {
+    // What the audio thread is playing
+    int currentSample = -1;
+    // What it's been told to play, which is what everybody else should show. Ahead of currentSample
+    // while a chooseSample command is still in the queue.
+    std::atomic<int> selectedSample{ -1 };
+    // Playback position, 32.32 fixed point so looping never drifts
+    juce::uint64 phase = 0;
+    int note = -1;
+    bool playing = false;
+    double frequency = -1;
+    double fineTuning = 1;
+    double lastPB = 1;
+    double pitchBend = 1;
+    double sourceFrequency = -1;
+    double targetFrequency = -1;
+    bool waitingForOuterReset = true;
+    // Output bus for the part's slots that don't pick their own
+    std::atomic<int> bus{ 0 };
+
+    // The polyphonic voice pool. Each field is its own array so the voice loops in processBlock and
+    // noteOn walk contiguous memory, only the first numVoices are used.
+    bool voiceActive[MAX_VOICES] = {};
+    int voiceNote[MAX_VOICES] = {};
+    int voiceSlot[MAX_VOICES] = {};
+    juce::uint64 voicePhase[MAX_VOICES] = {};
+    double voiceFrequency[MAX_VOICES] = {};
+    juce::uint64 voiceAge[MAX_VOICES] = {};
+};
+
+//==============================================================================
+/*
+    Something the UI or the host wants done to the synth. They're queued up and
+    applied by the audio thread offset samples into its next block, so nothing
+    changes under it in the middle of rendering.
+*/
+struct SynthCommand {
+    enum Type {
+        chooseSample,   // value is the slot
+        reset,          // part's current slot, every part's for part -1
+        resetAll,       // every slot for part, or for every part for part -1
+        allNotesOff,
+        transpose,      // value semitones, amount cents
+        frequencyFactor,// amount in semitones
+        tuning,         // value in cents
+        polyphony,      // value voices
+        voiceStealing,  // value is a VoiceStealing
+        multiTimbral,   // value 0 or 1
+        bus,            // value is the bus for part
+        pitchBend       // amount is the wheel position for part, -1 to +1
+    };
+
+    Type type;
+    int value = 0;
+    double amount = 0;
+    int part = 0;
+    int offset = 0;
+};
+
+//==============================================================================
+/*
+    Everything that changes what's playing (chooseSample, reset, noteOn, the
+    setters...) is for the audio thread, or whatever's standing in for it like
+    S3Bench. Everyone else posts a SynthCommand.
 */
 class SamplerSynthesizer
 {
@@ -38,116 +154,178 @@ public:
         this->sampleRate = sampleRate;
     }
 
-    void processBlock(juce::AudioBuffer<float>& buffer, int beginSample, int endSample);
-
-    int loadSample(juce::File audioFile, double rootFrequency, int samplePosition, bool loop = true);
+    // Audio thread, once at the start of every block, before any processBlock calls for it.
+    // Picks up the commands posted since the last block and applies the ones for its first sample.
+    void beginBlock(int numSamples);
+    // Applies the block's commands as it gets to them
+    void processBlock(juce::AudioBuffer<float>& buffer, int beginSample, int endSample) {
+        processBlock(&buffer, 1, beginSample, endSample);
+    }
+    // Same with an output bus per buffer, buses[0] is the main one. Every bus gets all of beginSample to
+    // endSample written, the ones nothing's routed to come out silent. A bus with no channels (one the host
+    // has turned off) plays on the main bus instead.
+    void processBlock(juce::AudioBuffer<float>* buses, int numBuses, int beginSample, int endSample);
+
+    // Any thread. Returns false if the queue's full, which takes a lot of clicking. Nothing changes then,
+    // not even getCurrentSample().
+    bool post(const SynthCommand& command);
+
+    int loadSample(juce::File audioFile, double rootFrequency, int samplePosition, bool loop = true, bool stream = false);
+    bool setSampleStreaming(int samplePosition, bool stream);
+
+    // On, 16 bit files stay 16 bit in memory, which sounds exactly the same in half the RAM.
+    // Only affects samples loaded after it's changed.
+    void setCompactStorage(bool shouldBeCompact) {
+        compactStorage = shouldBeCompact;
+    }
 
     bool unloadSample(int samplePosition);
-    int chooseSample(int samplePosition);
+    int chooseSample(int samplePosition, int part = 0);
+
+    SampleLoader& getLoader() {
+        return loader;
+    }
+
+    ResidencyManager& getResidency() {
+        return residency;
+    }
+
+   #if S3_TELEMETRY
+    // Where the loader and the streamer say what they're up to, null for nowhere
+    void setTelemetry(Telemetry* newTelemetry) {
+        telemetry = newTelemetry;
+        streamer.setTelemetry(newTelemetry);
+    }
+   #endif
+
+    bool isSampleLoading(int sample) {
+        SampleSlot* slot = samples.find(sample);
+        return slot != nullptr && slot->loading;
+    }
+
+    bool isSampleStreaming(int sample) {
+        SampleSlot* slot = samples.find(sample);
+        return slot != nullptr && slot->streaming;
+    }
 
     int getNumSamples() {
-        return numSamples;
+        return samples.getNumOccupied();
     }
 
-    int getCurrentSample() {
-        return currentSample;
+    int getCurrentSample(int part = 0) {
+        return parts[part].selectedSample;
     }
 
     juce::String getCurrentSampleName() {
-        return samples[currentSample].fileName;
+        return getSampleName(parts[0].selectedSample);
     }
 
     juce::String getSampleName(int sample) {
         if (sample < 0 || sample >= MAX_SAMPLES) return "";
-        return samples[sample].fileName;
+        SampleSlot* slot = samples.find(sample);
+        if (slot == nullptr) return "Not Loaded";
+        const juce::ScopedLock lock(slotLock);
+        return slot->fileName;
+    }
+
+    // Not on the audio thread. Null if the slot's empty or the overview isn't ready yet.
+    std::shared_ptr<const SampleOverview> getSampleOverview(int sample) {
+        SampleSlot* slot = samples.find(sample);
+        if (slot == nullptr) return nullptr;
+        const juce::ScopedLock lock(slotLock);
+        return slot->overview;
+    }
+
+    // Any thread. -1 follows the part, see setPartBus().
+    void setSampleBus(int sample, int bus) {
+        if (SampleSlot* slot = samples.find(sample)) slot->bus = juce::jlimit(-1, MAX_BUSES - 1, bus);
+    }
+    int getSampleBus(int sample) {
+        SampleSlot* slot = samples.find(sample);
+        return slot != nullptr ? slot->bus.load() : -1;
+    }
+    // Where a part plays the slots that don't have a bus of their own, so in multi-timbral mode each
+    // MIDI channel can have its own output
+    void setPartBus(int part, int bus) {
+        parts[part].bus = juce::jlimit(0, MAX_BUSES - 1, bus);
+    }
+    int getPartBus(int part) {
+        return parts[part].bus;
     }
 
     void setCurrentSampleLoop(bool loop) {
-        if (currentSample < 0) return;
-        samples[currentSample].loop = loop;
+        if (SampleSlot* slot = samples.find(parts[0].selectedSample)) slot->loop = loop;
     }
     void setCurrentSampleRootFrequency(double frequency) {
-        if (currentSample < 0) return;
-        samples[currentSample].rootFrequency = frequency;
+        if (SampleSlot* slot = samples.find(parts[0].selectedSample)) slot->rootFrequency = frequency;
+    }
+
+    // Frees retired sample data the audio thread is done with, never call this on the audio thread
+    void collectGarbage() {
+        reclaimer.collect();
     }
     void setCurrentSampleRootNote(int note) {
-        if (currentSample < 0) return;
-        samples[currentSample].rootFrequency = midiNoteNumberToFrequency(note);
-    }
-
-    std::vector<int> getLoadedSamples() {
-        std::vector<int> loaded;
-        numSamples = 0;
-        for (int i = 0; i < MAX_SAMPLES; i++) {
-            if (samples[i].loaded) {
-                loaded.push_back(i);
-                numSamples++;
-            }
-        }
-        return loaded;
+        if (SampleSlot* slot = samples.find(parts[0].selectedSample)) slot->rootFrequency = midiNoteNumberToFrequency(note);
     }
 
-    void noteOn(int number);
-    void noteOff(int number);
-    void noteOff() {
-        playing = false;
+    // Fills loaded with the loaded slots in order, reusing whatever it's already allocated
+    void getLoadedSamples(std::vector<int>& loaded) {
+        loaded.clear();
+        samples.forEachOccupied([&loaded](int i) { loaded.push_back(i); });
     }
-    void noteMessage(int number, int on) {
-        if (on) noteOn(number);
-        else noteOff(number);
+
+    void noteOn(int number, int part = 0);
+    void noteOff(int number, int part = 0);
+    // Stops everything
+    void noteOff();
+    void noteMessage(int number, int on, int part = 0) {
+        if (on) noteOn(number, part);
+        else noteOff(number, part);
     }
 
+    // Resets a slot in every part
     void reset(int pos);
-    void reset() {
-        reset(currentSample);
-        waitingForOuterReset = true;
-    }
-    void resetAllSamples() {
-        for (int i = 0; i < MAX_SAMPLES; i++) {
-            reset(i);
-        }
-        waitingForOuterReset = true;
-    }
+    // Resets every part's current slot
+    void reset();
+    void resetAllSamples();
+    // Same for one part, the others carry on where they are
+    void resetPart(int part);
+    void resetAllSamples(int part);
 
     int getOpenSample() {
-        for (int i = 0; i < MAX_SAMPLES; i++) {
-            if (!samples[i].loaded) {
-                return i;
-            }
-        }
-        return -1;
+        return samples.findFirstFree();
     }
 
-    int chooseNextSample() {
-        for (int i = currentSample + 1; i < MAX_SAMPLES; i++) {
-            if (samples[i].loaded) {
-                return chooseSample(i);
-            }
-        }
-        for (int i = 0; i <= currentSample; i++) {
-            if (samples[i].loaded) {
-                return chooseSample(i);
-            }
-        }
-        return -1;
+    // Message thread. The loaded slots either side of the first part's, -1 if there's nothing loaded.
+    int findNextSample() {
+        return samples.findNextOccupied(parts[0].selectedSample);
+    }
+    int findPrevSample() {
+        return samples.findPrevOccupied(parts[0].selectedSample);
     }
 
-    int choosePrevSample() {
-        for (int i = currentSample - 1; i >= 0; i--) {
-            if (samples[i].loaded) {
-                return chooseSample(i);
-            }
-        }
-        for (int i = MAX_SAMPLES - 1; i >= currentSample; i--) {
-            if (samples[i].loaded) {
-                return chooseSample(i);
-            }
-        }
-        return -1;
+    // 1 is the usual monophonic mode, anything more plays every note on its own voice
+    void setPolyphony(int voices);
+    int getPolyphony() {
+        return numVoices;
+    }
+    void setVoiceStealing(VoiceStealing stealing) {
+        voiceStealing = stealing;
+    }
+
+    // Off, everything plays on the first part. On, MIDI channel n plays part n - 1 and they all get mixed onto
+    // their buses.
+    void setMultiTimbral(bool shouldBeMultiTimbral) {
+        multiTimbral = shouldBeMultiTimbral;
+    }
+    bool isMultiTimbral() {
+        return multiTimbral;
     }
 
     void getXmlState(juce::XmlElement* parent);
-    void loadXmlState(juce::XmlElement* state);
+    // Message thread. The slots get loaded straight away. The parts are the audio thread's, so what they need to
+    // get back to the state is added to partCommands for the caller to post.
+    void loadXmlState(juce::XmlElement* state, std::vector<SynthCommand>& partCommands);
 
     // accurate to 2^x above -3 octaves, drops to 0 from -3 to -4 octaves with continuous derivative
     void setFrequencyFactor(double semitones) {
@@ -156,7 +334,9 @@ public:
         else {
             frequencyFactor = std::pow((semitones / 12.0) + 4.0, 0.6935) / 8.0;
         }
-        frequency = targetFrequency * frequencyFactor;
+        for (SamplerPart& part : parts) {
+            part.frequency = part.targetFrequency * frequencyFactor;
+        }
     }
 
     void transpose(int semitones, double cents = 0);
@@ -169,46 +349,144 @@ public:
     void setTuning(int cents) {
         tuning = (std::pow(2.0, (cents / 1200)));
     }
+    // On top of the tuning above, for one part
+    void setFineTuning(double cents, int part) {
+        parts[part].fineTuning = std::pow(2.0, cents / 1200.0);
+    }
 
-    void setPitchBend(float wheelPosition) {
-        lastPB = pitchBend;
-        pitchBend = std::pow(2.0, wheelPosition * 2.0 / 12.0);
+    void setPitchBend(float wheelPosition, int part = 0) {
+        parts[part].lastPB = parts[part].pitchBend;
+        parts[part].pitchBend = std::pow(2.0, wheelPosition * 2.0 / 12.0);
     }
 
 private:
-    void recalculateNumSamples() {
-        numSamples = 0;
-        for (int i = 0; i < MAX_SAMPLES; i++) {
-            if (samples[i].loaded) {
-                numSamples++;
-            }
-        }
+    friend class SampleLoader;
+    friend class ResidencyManager;
+
+    // Called from the loader thread, returns true if the slot still wanted data
+    bool publishSample(int samplePosition, int generation, std::shared_ptr<const SampleData> data);
+    // Call with the slot lock held
+    void retireSample(SampleSlot& slot);
+    // Also from the loader thread, for building the overview. Null if the slot has moved on from generation.
+    std::shared_ptr<const SampleData> getSampleData(int samplePosition, int generation);
+    bool setSampleOverview(int samplePosition, int generation, std::shared_ptr<const SampleOverview> overview);
+    bool isLoadCancelled(int samplePosition, int generation) {
+        return samples.get(samplePosition).generation != generation;
     }
+    // Called on the message thread when a load job failed
+    void abandonLoad(int samplePosition, int generation);
 
+    void loadXmlSlot(juce::XmlElement* slot);
+
+    int getPartIndex(const SamplerPart& part) const {
+        return int(&part - parts);
+    }
+
+    void applyCommand(const SynthCommand& command);
+    void resetSlot(SamplerPart& part, int slotNum, SampleSlot& slot);
 
     static double lerp_f(double start, double end, double t) {
         return (end - start) * t + start;
     }
 
+    // What the renderer needs for one processBlock call. increment is the step for the next frame
+    // (32.32 like phase), it moves by delta every frame while the pitch bend ramps.
+    struct Segment {
+        const SampleData* data = nullptr;
+        juce::int64 numFrames = 0;
+        int endSample = 0;
+        juce::int64 increment = 0;
+        juce::int64 delta = 0;
+        // Add to the buffer instead of replacing what's there
+        bool mix = false;
+        // Sample channels rendered and outputs written. They're the same unless it's a mono sample going to
+        // both of the first two outputs (broadcast).
+        int numChannels = 0;
+        int numOutputs = 0;
+        bool broadcast = false;
+    };
+
+    // Whichever voice gets to a bus first in a renderBlock call replaces what's there, the rest mix into it.
+    // written says which ones have been got to so far.
+    void renderBlock(juce::AudioBuffer<float>* buses, int numBuses, int beginSample, int endSample);
+    void renderPart(juce::AudioBuffer<float>* buses, int numBuses, bool* written, int beginSample, int endSample, SamplerPart& part);
+    void renderVoices(juce::AudioBuffer<float>* buses, int numBuses, bool* written, int beginSample, int endSample, SamplerPart& part);
+    // The bus a slot plays into for a part, the main one if that bus isn't there
+    static int getBus(const juce::AudioBuffer<float>* buses, int numBuses, const SamplerPart& part, const SampleSlot& slot) {
+        int bus = slot.bus.load();
+        if (bus < 0) bus = part.bus.load();
+        return bus < numBuses && buses[bus].getNumChannels() > 0 ? bus : 0;
+    }
+    bool renderVoice(juce::AudioBuffer<float>& buffer, int beginSample, int endSample, const SamplerPart& part, const SampleSlot& slot, const SampleData* data, double frequency, juce::uint64& phase, bool mix);
+
+    // Which renderRun a segment gets, picked once per renderVoice call. unity is one frame per frame (a straight copy
+    // when the phase is on a whole frame), integer skips a whole number of frames, fractional has a constant increment,
+    // and bend is everything else.
+    enum class Kernel { unity, integer, fractional, bend };
+    template <Kernel kernel, bool loop>
+    bool renderSegment(juce::AudioBuffer<float>& buffer, int sampleNow, Segment& segment, juce::uint64& phase);
+    template <Kernel kernel>
+    int renderRun(juce::AudioBuffer<float>& buffer, int sampleNow, Segment& segment, juce::uint64& phase);
+    void renderFrame(juce::AudioBuffer<float>& buffer, int sampleNow, const Segment& segment, juce::uint64 phase);
+
+    // A streamed slot can only be played from one place at a time. The part that read it in the last render
+    // call keeps it and any other part stays quiet until it's done, returns false for those.
+    bool claimReader(SampleSlot& slot, const SampleData* data, int part);
+    juce::uint64 renderCount = 0;
+
+    void startVoice(SamplerPart& part, int note);
+    int findVoiceToSteal(const SamplerPart& part);
+
+    // One frame in phase units
+    static constexpr double phaseOne = 4294967296.0;
+
     double sampleRate = 192000;
 
-    SampleSlot samples[MAX_SAMPLES];
-    int numSamples = 0;
-    int currentSample = -1;
+    // Most frames the renderer asks a SampleData for at once, scratch has one extra frame for loop wraparound
+    static constexpr int scratchFrames = 2048;
+    juce::AudioBuffer<float> scratch{ SampleData::maxChannels, scratchFrames + 1 };
+
+    // Most frames renderRun does at once (unity runs without a fraction go up to scratchFrames), and where it keeps
+    // its positions and frames
+    static constexpr int kernelFrames = 256;
+    int runIndex[kernelFrames];
+    float runFraction[kernelFrames];
+    float runHere[kernelFrames];
+    float runDelta[kernelFrames];
+
+    // Only the pages of slots that have been used are allocated
+    SlotBank<SampleSlot, MAX_SAMPLES> samples;
+    bool compactStorage = true;
+
+    SamplerPart parts[MAX_PARTS];
+    bool multiTimbral = false;
+
+    // Posted commands wait in the queue until the next block, then they're sorted into blockCommands
+    static constexpr int maxCommands = 1024;
+    CommandQueue<SynthCommand, maxCommands> commands;
+    SynthCommand blockCommands[maxCommands];
+    int numBlockCommands = 0;
+    int nextBlockCommand = 0;
 
-    double time = 0;
-    int note = -1;
-    bool playing = false;
-    double frequency = -1;
     double tuning = 1;
-    double lastPB = 1;
-    double pitchBend = 1;
-    double sourceFrequency = -1;
-    double targetFrequency = -1;
     double frequencyFactor = 1;
 
-    bool waitingForOuterReset = true;
+    int numVoices = 1;
+    VoiceStealing voiceStealing = VoiceStealing::oldest;
+    juce::uint64 nextVoiceAge = 0;
+
+    // Guards slot publication against ejecting, never taken on the audio thread
+    juce::CriticalSection slotLock;
+    // Declared before the reclaimer, streamed data unregisters itself from the streamer when it's deleted
+    SampleStreamer streamer;
+    EpochReclaimer<SampleData> reclaimer;
+    SampleLoader loader{ *this };
+
+   #if S3_TELEMETRY
+    std::atomic<Telemetry*> telemetry{ nullptr };
+   #endif
+    // Last so it stops before anything it looks at goes away
+    ResidencyManager residency{ *this };
 
-    juce::AudioFormatManager manager;
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SamplerSynthesizer)
 };
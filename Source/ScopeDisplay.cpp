@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    ScopeDisplay.cpp
+    Created: 17 Oct 2026 6:40:27pm
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "ScopeDisplay.h"
+
+//==============================================================================
+ScopeDisplay::ScopeDisplay(ScopeFeed& feed)
+    : feed(feed), left(ScopeFeed::capacity), right(ScopeFeed::capacity), fade(std::pow(persistence, 1.0f / frameRate))
+{
+    setOpaque(true);
+    feed.setActive(true);
+    startTimerHz(frameRate);
+}
+
+ScopeDisplay::~ScopeDisplay()
+{
+    stopTimer();
+    feed.setActive(false);
+}
+
+void ScopeDisplay::resized() {
+    trace = juce::Image(juce::Image::ARGB, juce::jmax(1, getWidth()), juce::jmax(1, getHeight()), true);
+}
+
+void ScopeDisplay::timerCallback() {
+    // Always empty the feed, even if there's nowhere to draw it
+    int num = feed.pull(left, right, ScopeFeed::capacity);
+    if (trace.isNull()) return;
+
+    trace.multiplyAllAlphas(fade);
+    if (num > 1) {
+        float centreX = trace.getWidth() * 0.5f;
+        float centreY = trace.getHeight() * 0.5f;
+        float scale = juce::jmin(centreX, centreY);
+
+        juce::Path path;
+        path.preallocateSpace(num * 3);
+        path.startNewSubPath(centreX + left[0] * scale, centreY - right[0] * scale);
+        for (int i = 1; i < num; i++) {
+            path.lineTo(centreX + left[i] * scale, centreY - right[i] * scale);
+        }
+
+        juce::Graphics g(trace);
+        g.setColour(juce::Colour::fromRGB(90, 230, 120).withAlpha(0.7f));
+        g.strokePath(path, juce::PathStrokeType(1.0f));
+    }
+    repaint();
+}
+
+void ScopeDisplay::paint(juce::Graphics& g) {
+    g.fillAll(juce::Colours::black);
+    g.drawImageAt(trace, 0, 0);
+    g.setColour(getLookAndFeel().findColour(juce::Label::textColourId));
+    g.drawRect(getLocalBounds());
+}
@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+    ScopeDisplay.h
+    Created: 17 Oct 2026 6:40:27pm
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "ScopeFeed.h"
+
+//==============================================================================
+/*
+    A live XY scope of whatever's coming out of a ScopeFeed, left channel across
+    and right channel up. The trace is drawn into an image that fades a little
+    every frame, so it looks like a real scope's phosphor.
+*/
+class ScopeDisplay : public juce::Component, private juce::Timer
+{
+public:
+    ScopeDisplay(ScopeFeed& feed);
+    ~ScopeDisplay() override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+private:
+    void timerCallback() override;
+
+    // Never redrawn faster than this, however fast frames come in
+    static constexpr int frameRate = 30;
+    // How bright the trace still is after a second
+    static constexpr float persistence = 0.02f;
+
+    ScopeFeed& feed;
+    juce::HeapBlock<float> left;
+    juce::HeapBlock<float> right;
+    juce::Image trace;
+    float fade;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ScopeDisplay)
+};
@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    ScopeFeed.h
+    Created: 17 Oct 2026 6:24:03pm
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+    Gets what S3 is playing from the audio thread to the editor's scope. The
+    audio thread pushes every decimation'th frame into a lock-free FIFO, the
+    editor pulls them out whenever it gets round to it. If it doesn't (or
+    nobody's watching), frames are dropped, the audio thread never waits.
+*/
+class ScopeFeed
+{
+public:
+    // About a second at the rate the scope gets frames
+    static constexpr int capacity = 1 << 16;
+    // Frames per second the scope gets, give or take, whatever the host's running at
+    static constexpr double scopeRate = 48000;
+
+    ScopeFeed() = default;
+
+    void prepare(double sampleRate) {
+        decimation = juce::jmax(1, juce::roundToInt(sampleRate / scopeRate));
+    }
+
+    // The editor turns this on while it's showing the scope, push does nothing otherwise
+    // (message thread). Anything left over from last time is thrown away, only the reading side can do that.
+    void setActive(bool shouldBeActive) {
+        if (shouldBeActive && active == false) fifo.finishedRead(fifo.getNumReady());
+        active = shouldBeActive;
+    }
+
+    // Audio thread. Whatever doesn't fit is dropped.
+    void push(const float* left, const float* right, int num) noexcept {
+        if (active == false) return;
+        int step = decimation;
+        if (skip >= step) skip = 0;
+
+        // Every step'th frame, carrying on from the last block
+        int count = skip < num ? (num - 1 - skip) / step + 1 : 0;
+        int first = skip;
+        skip = count > 0 ? first + count * step - num : skip - num;
+        if (count == 0) return;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(count, start1, size1, start2, size2);
+        for (int i = 0; i < size1; i++) {
+            frames[0][start1 + i] = left[first + i * step];
+            frames[1][start1 + i] = right[first + i * step];
+        }
+        first += size1 * step;
+        for (int i = 0; i < size2; i++) {
+            frames[0][start2 + i] = left[first + i * step];
+            frames[1][start2 + i] = right[first + i * step];
+        }
+        fifo.finishedWrite(size1 + size2);
+    }
+
+    // Message thread. Returns how many frames it got, at most max.
+    int pull(float* left, float* right, int max) noexcept {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(max, start1, size1, start2, size2);
+        std::copy(frames[0] + start1, frames[0] + start1 + size1, left);
+        std::copy(frames[1] + start1, frames[1] + start1 + size1, right);
+        std::copy(frames[0] + start2, frames[0] + start2 + size2, left + size1);
+        std::copy(frames[1] + start2, frames[1] + start2 + size2, right + size1);
+        fifo.finishedRead(size1 + size2);
+        return size1 + size2;
+    }
+
+private:
+    juce::AbstractFifo fifo{ capacity };
+    float frames[2][capacity];
+
+    std::atomic<bool> active{ false };
+    std::atomic<int> decimation{ 1 };
+    // Audio thread only, frames to skip before the next one the scope gets
+    int skip = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (ScopeFeed)
+};
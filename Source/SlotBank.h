@@ -0,0 +1,196 @@
+/*
+  ==============================================================================
+
+    SlotBank.h
+    Created: 17 Oct 2026 4:08:31pm
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+#if JUCE_MSVC
+ #include <intrin.h>
+#endif
+
+//==============================================================================
+/*
+    Storage for a lot of slots when only a few of them are ever used. Slots
+    live in pages of 64 that only get allocated when something's put in one
+    of them, and never go away until the bank does, so the audio thread can
+    look a slot up without worrying about it disappearing.
+
+    Which slots are occupied is kept in a two level bitmap, one bit per slot
+    and one bit per 64 slots, so finding the next, previous or first free
+    slot is a couple of bit scans no matter how many slots there are.
+
+    Occupancy is only changed and searched on the message thread.
+*/
+template <typename Slot, int numSlots>
+class SlotBank
+{
+public:
+    static_assert(numSlots > 0 && numSlots % 64 == 0 && numSlots <= 64 * 64, "The summary has to fit in one word");
+
+    SlotBank() = default;
+
+    ~SlotBank() {
+        for (auto& page : pages) delete[] page.load();
+    }
+
+    // Any thread. Null if the slot has never been used.
+    Slot* find(int pos) const noexcept {
+        if (pos < 0 || pos >= numSlots) return nullptr;
+        Slot* page = pages[pos / pageSlots].load(std::memory_order_acquire);
+        return page == nullptr ? nullptr : page + (pos % pageSlots);
+    }
+
+    // Never on the audio thread, allocates the slot's page the first time it's needed
+    Slot& get(int pos) {
+        jassert(pos >= 0 && pos < numSlots);
+        std::atomic<Slot*>& page = pages[pos / pageSlots];
+        if (page.load(std::memory_order_acquire) == nullptr) {
+            const juce::ScopedLock lock(pageLock);
+            if (page.load(std::memory_order_relaxed) == nullptr) page.store(new Slot[pageSlots], std::memory_order_release);
+        }
+        return page.load(std::memory_order_relaxed)[pos % pageSlots];
+    }
+
+    void setOccupied(int pos, bool occupied) {
+        int w = pos / 64;
+        juce::uint64 bit = juce::uint64(1) << (pos % 64);
+        if (((words[w] & bit) != 0) == occupied) return;
+
+        words[w] ^= bit;
+        numOccupied += occupied ? 1 : -1;
+        setBit(used, w, words[w] != 0);
+        setBit(full, w, words[w] == ~juce::uint64(0));
+    }
+
+    bool isOccupied(int pos) const noexcept {
+        if (pos < 0 || pos >= numSlots) return false;
+        return (words[pos / 64] >> (pos % 64)) & 1;
+    }
+
+    int getNumOccupied() const noexcept {
+        return numOccupied;
+    }
+
+    // The first occupied slot after pos, going round to the start (and pos itself) if there's none. -1 if they're all free.
+    int findNextOccupied(int pos) const noexcept {
+        int next = firstOccupiedFrom(pos + 1);
+        return next >= 0 ? next : firstOccupiedFrom(0);
+    }
+
+    // Same as above, going the other way
+    int findPrevOccupied(int pos) const noexcept {
+        int prev = lastOccupiedUpTo(pos - 1);
+        return prev >= 0 ? prev : lastOccupiedUpTo(numSlots - 1);
+    }
+
+    // -1 if every slot is occupied
+    int findFirstFree() const noexcept {
+        juce::uint64 notFull = ~full & allWords;
+        if (notFull == 0) return -1;
+        int w = lowestBit(notFull);
+        return w * 64 + lowestBit(~words[w]);
+    }
+
+    // Calls f(pos, slot) for every slot in a page that's been allocated, occupied or not. Fine on the audio thread.
+    template <typename Function>
+    void forEachAllocated(Function&& f) const {
+        for (int p = 0; p < numPages; p++) {
+            Slot* page = pages[p].load(std::memory_order_acquire);
+            if (page == nullptr) continue;
+            for (int i = 0; i < pageSlots; i++) {
+                f(p * pageSlots + i, page[i]);
+            }
+        }
+    }
+
+    // Calls f with every occupied slot number in order
+    template <typename Function>
+    void forEachOccupied(Function&& f) const {
+        for (juce::uint64 u = used; u != 0; u &= u - 1) {
+            int w = lowestBit(u);
+            for (juce::uint64 bits = words[w]; bits != 0; bits &= bits - 1) {
+                f(w * 64 + lowestBit(bits));
+            }
+        }
+    }
+
+private:
+    static constexpr int pageSlots = 64;
+    static constexpr int numPages = numSlots / pageSlots;
+    static constexpr int numWords = numSlots / 64;
+    static constexpr juce::uint64 allWords = numWords == 64 ? ~juce::uint64(0) : (juce::uint64(1) << numWords) - 1;
+
+    // Neither of these is ever called with 0
+    static int lowestBit(juce::uint64 bits) noexcept {
+       #if JUCE_MSVC
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return int(index);
+       #else
+        return __builtin_ctzll(bits);
+       #endif
+    }
+
+    static int highestBit(juce::uint64 bits) noexcept {
+       #if JUCE_MSVC
+        unsigned long index;
+        _BitScanReverse64(&index, bits);
+        return int(index);
+       #else
+        return 63 - __builtin_clzll(bits);
+       #endif
+    }
+
+    static void setBit(juce::uint64& bits, int bit, bool value) noexcept {
+        if (value) bits |= juce::uint64(1) << bit;
+        else bits &= ~(juce::uint64(1) << bit);
+    }
+
+    // Lowest occupied slot at or above start, -1 if there isn't one
+    int firstOccupiedFrom(int start) const noexcept {
+        if (start >= numSlots) return -1;
+        start = juce::jmax(0, start);
+
+        int w = start / 64;
+        juce::uint64 bits = words[w] & (~juce::uint64(0) << (start % 64));
+        if (bits != 0) return w * 64 + lowestBit(bits);
+
+        juce::uint64 rest = w + 1 < 64 ? used & (~juce::uint64(0) << (w + 1)) : 0;
+        if (rest == 0) return -1;
+        w = lowestBit(rest);
+        return w * 64 + lowestBit(words[w]);
+    }
+
+    // Highest occupied slot at or below end, -1 if there isn't one
+    int lastOccupiedUpTo(int end) const noexcept {
+        if (end < 0) return -1;
+        end = juce::jmin(numSlots - 1, end);
+
+        int w = end / 64;
+        juce::uint64 bits = words[w] & (~juce::uint64(0) >> (63 - end % 64));
+        if (bits != 0) return w * 64 + highestBit(bits);
+
+        juce::uint64 rest = used & ((juce::uint64(1) << w) - 1);
+        if (rest == 0) return -1;
+        w = highestBit(rest);
+        return w * 64 + highestBit(words[w]);
+    }
+
+    std::atomic<Slot*> pages[numPages] = {};
+    juce::CriticalSection pageLock;
+
+    juce::uint64 words[numWords] = {};
+    // One bit per word, set if it has any slots occupied / all of them
+    juce::uint64 used = 0;
+    juce::uint64 full = 0;
+    int numOccupied = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (SlotBank)
+};
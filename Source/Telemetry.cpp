@@ -0,0 +1,157 @@
+/*
+  ==============================================================================
+
+    Telemetry.cpp
+    Created: 17 Oct 2026 7:05:50pm
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "Telemetry.h"
+
+#if S3_TELEMETRY
+
+//==============================================================================
+Telemetry::ScopedEvent::ScopedEvent(Telemetry* telemetry, const char* name, int track, double value) noexcept
+    : telemetry(telemetry)
+{
+    if (telemetry == nullptr) return;
+    event.name = name;
+    event.track = track;
+    event.value = value;
+    event.start = juce::Time::getHighResolutionTicks();
+}
+
+Telemetry::ScopedEvent::~ScopedEvent()
+{
+    if (telemetry == nullptr) return;
+    event.end = juce::Time::getHighResolutionTicks();
+    telemetry->record(event);
+}
+
+Telemetry::ScopedBlock::ScopedBlock(Telemetry& telemetry, int numSamples) noexcept
+    : telemetry(telemetry), numSamples(numSamples), start(juce::Time::getHighResolutionTicks())
+{
+}
+
+Telemetry::ScopedBlock::~ScopedBlock()
+{
+    telemetry.endBlock(start, juce::Time::getHighResolutionTicks(), numSamples);
+}
+
+//==============================================================================
+Telemetry::Telemetry()
+    : history(historySize), origin(juce::Time::getHighResolutionTicks())
+{
+    for (auto& bucket : histogram) bucket = 0;
+    startTimerHz(drainRate);
+}
+
+Telemetry::~Telemetry()
+{
+    stopTimer();
+}
+
+void Telemetry::record(const Event& event) noexcept {
+    if (queue.push(event) == false) dropped++;
+}
+
+void Telemetry::endBlock(juce::int64 start, juce::int64 end, int numSamples) noexcept {
+    if (numSamples <= 0) return;
+    if (resetPending.exchange(false)) {
+        blocks = 0;
+        overruns = 0;
+        peakLoad = 0;
+        totalTime = 0;
+        totalBudget = 0;
+        for (auto& bucket : histogram) bucket = 0;
+    }
+
+    double time = juce::Time::highResolutionTicksToSeconds(end - start);
+    double budget = numSamples / sampleRate.load();
+    double load = time / budget;
+
+    blocks.store(blocks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (load > 1.0) overruns.store(overruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    lastLoad.store(load, std::memory_order_relaxed);
+    if (load > peakLoad.load(std::memory_order_relaxed)) peakLoad.store(load, std::memory_order_relaxed);
+    totalTime.store(totalTime.load(std::memory_order_relaxed) + time, std::memory_order_relaxed);
+    totalBudget.store(totalBudget.load(std::memory_order_relaxed) + budget, std::memory_order_relaxed);
+
+    auto& bucket = histogram[juce::jlimit(0, numBuckets - 1, int(load * 10.0))];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    // The block shows up in the trace too, with how much of the budget it used
+    record({ "processBlock", audioTrack, start, end, load });
+}
+
+void Telemetry::timerCallback() {
+    Event event;
+    while (queue.pop(event)) {
+        history[historyNext % historySize] = event;
+        historyNext++;
+    }
+}
+
+Telemetry::Stats Telemetry::getStats() const {
+    Stats stats;
+    stats.blocks = blocks.load(std::memory_order_relaxed);
+    stats.overruns = overruns.load(std::memory_order_relaxed);
+    stats.droppedEvents = dropped.load(std::memory_order_relaxed);
+    stats.lastLoad = lastLoad.load(std::memory_order_relaxed);
+    stats.peakLoad = peakLoad.load(std::memory_order_relaxed);
+    double budget = totalBudget.load(std::memory_order_relaxed);
+    stats.meanLoad = budget > 0 ? totalTime.load(std::memory_order_relaxed) / budget : 0;
+    for (int i = 0; i < numBuckets; i++) {
+        stats.histogram[i] = histogram[i].load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+void Telemetry::reset() {
+    resetPending = true;
+    dropped = 0;
+    lastLoad = 0;
+    historyNext = 0;
+}
+
+// Chrome's trace event format, which Perfetto reads too. Times are in microseconds from when we were made.
+bool Telemetry::exportTrace(const juce::File& file) {
+    timerCallback();
+
+    juce::FileOutputStream out(file);
+    if (out.failedToOpen()) return false;
+    out.setPosition(0);
+    out.truncate();
+
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    auto next = [&]() -> juce::OutputStream& {
+        out << (first ? "\n" : ",\n");
+        first = false;
+        return out;
+    };
+
+    const char* trackNames[] = { "", "Audio", "Loader", "Streamer" };
+    for (int track = audioTrack; track <= streamerTrack; track++) {
+        next() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track
+               << ",\"args\":{\"name\":\"" << trackNames[track] << "\"}}";
+    }
+
+    size_t num = juce::jmin(historyNext, size_t(historySize));
+    for (size_t i = historyNext - num; i < historyNext; i++) {
+        const Event& event = history[i % historySize];
+        double start = juce::Time::highResolutionTicksToSeconds(event.start - origin) * 1.0e6;
+        double duration = juce::Time::highResolutionTicksToSeconds(event.end - event.start) * 1.0e6;
+        next() << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.track
+               << ",\"ts\":" << juce::String(start, 3) << ",\"dur\":" << juce::String(duration, 3)
+               << ",\"args\":{\"value\":" << juce::String(event.value, 4) << "}}";
+    }
+    out << "\n]}\n";
+    out.flush();
+    return out.getStatus().wasOk();
+}
+
+#endif
@@ -0,0 +1,147 @@
+/*
+  ==============================================================================
+
+    Telemetry.h
+    Created: 17 Oct 2026 7:05:50pm
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// Turned on (S3_TELEMETRY=1) in the plugin's Debug and Diagnostics configurations. Off, none of this exists and the macros at the bottom
+// compile to nothing.
+#ifndef S3_TELEMETRY
+ #define S3_TELEMETRY 0
+#endif
+
+#if S3_TELEMETRY
+#include "CommandQueue.h"
+
+//==============================================================================
+/*
+    Keeps track of how long processBlock takes compared to how long it's
+    allowed to (the block's length in real time), and of what the loader and
+    streamer threads are up to, so when a session glitches we can tell whether
+    it was us.
+
+    Every thread records through a lock-free queue, the message thread drains
+    it into a history that can be exported as a Chrome / Perfetto trace.
+*/
+class Telemetry : private juce::Timer
+{
+public:
+    // Each gets its own row in the trace
+    enum Track {
+        audioTrack = 1,
+        loaderTrack,
+        streamerTrack
+    };
+
+    struct Event {
+        // Has to be a string literal, it's kept around
+        const char* name = nullptr;
+        int track = audioTrack;
+        // High resolution ticks
+        juce::int64 start = 0;
+        juce::int64 end = 0;
+        // Shown as the event's argument, what it means depends on the event
+        double value = 0;
+    };
+
+    // Records how long its scope took, does nothing with a null Telemetry
+    class ScopedEvent {
+    public:
+        ScopedEvent(Telemetry* telemetry, const char* name, int track, double value) noexcept;
+        ~ScopedEvent();
+
+    private:
+        Telemetry* const telemetry;
+        Event event;
+        JUCE_DECLARE_NON_COPYABLE (ScopedEvent)
+    };
+
+    // Put one around processBlock
+    class ScopedBlock {
+    public:
+        ScopedBlock(Telemetry& telemetry, int numSamples) noexcept;
+        ~ScopedBlock();
+
+    private:
+        Telemetry& telemetry;
+        const int numSamples;
+        const juce::int64 start;
+        JUCE_DECLARE_NON_COPYABLE (ScopedBlock)
+    };
+
+    // Block times go in buckets of 10% of the budget, the last one is everything from 190% up
+    static constexpr int numBuckets = 20;
+
+    struct Stats {
+        juce::int64 blocks = 0;
+        // Blocks that took longer than they were allowed to
+        juce::int64 overruns = 0;
+        // Events that didn't fit in the queue
+        juce::int64 droppedEvents = 0;
+        // Fractions of the budget
+        double lastLoad = 0;
+        double peakLoad = 0;
+        double meanLoad = 0;
+        juce::int64 histogram[numBuckets] = {};
+    };
+
+    Telemetry();
+    ~Telemetry() override;
+
+    void prepare(double newSampleRate) {
+        sampleRate = newSampleRate;
+    }
+
+    // Any thread, never waits
+    void record(const Event& event) noexcept;
+
+    // Message thread
+    Stats getStats() const;
+    void reset();
+    // The last minute or so of events, returns false if the file couldn't be written
+    bool exportTrace(const juce::File& file);
+
+private:
+    void endBlock(juce::int64 start, juce::int64 end, int numSamples) noexcept;
+    void timerCallback() override;
+
+    static constexpr int queueSize = 4096;
+    static constexpr int historySize = 1 << 16;
+    // How often (Hz) the message thread empties the queue
+    static constexpr int drainRate = 10;
+
+    CommandQueue<Event, queueSize> queue;
+    std::atomic<juce::int64> dropped{ 0 };
+
+    // Message thread only, a ring of the latest events
+    std::vector<Event> history;
+    size_t historyNext = 0;
+    const juce::int64 origin;
+
+    // Written by the audio thread only, reset asks it to start over
+    std::atomic<double> sampleRate{ 44100 };
+    std::atomic<juce::int64> blocks{ 0 };
+    std::atomic<juce::int64> overruns{ 0 };
+    std::atomic<double> lastLoad{ 0 };
+    std::atomic<double> peakLoad{ 0 };
+    std::atomic<double> totalTime{ 0 };
+    std::atomic<double> totalBudget{ 0 };
+    std::atomic<juce::int64> histogram[numBuckets];
+    std::atomic<bool> resetPending{ false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Telemetry)
+};
+
+ #define S3_TELEMETRY_BLOCK(telemetry, numSamples) const Telemetry::ScopedBlock JUCE_JOIN_MACRO(s3Block, __LINE__) (telemetry, numSamples)
+ #define S3_TRACE(telemetry, name, track, value) const Telemetry::ScopedEvent JUCE_JOIN_MACRO(s3Trace, __LINE__) (telemetry, name, Telemetry::track, value)
+#else
+ #define S3_TELEMETRY_BLOCK(telemetry, numSamples)
+ #define S3_TRACE(telemetry, name, track, value)
+#endif
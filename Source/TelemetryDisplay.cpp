@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    TelemetryDisplay.cpp
+    Created: 17 Oct 2026 7:38:16pm
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "TelemetryDisplay.h"
+
+#if S3_TELEMETRY
+
+//==============================================================================
+TelemetryDisplay::TelemetryDisplay(Telemetry& telemetry)
+    : telemetry(telemetry)
+{
+    addAndMakeVisible(exportButton);
+    exportButton.addListener(this);
+    addAndMakeVisible(resetButton);
+    resetButton.addListener(this);
+
+    stats = telemetry.getStats();
+    startTimerHz(refreshRate);
+}
+
+TelemetryDisplay::~TelemetryDisplay()
+{
+    stopTimer();
+}
+
+void TelemetryDisplay::timerCallback() {
+    stats = telemetry.getStats();
+    repaint();
+}
+
+void TelemetryDisplay::buttonClicked(juce::Button* button) {
+    if (button == &exportButton) {
+        traceChooser.launchAsync(juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::canSelectFiles | juce::FileBrowserComponent::warnAboutOverwriting, [this](const juce::FileChooser& chooser)
+        {
+            juce::File traceFile(chooser.getResult());
+            if (traceFile == juce::File()) return;
+            if (telemetry.exportTrace(traceFile) == false) {
+                juce::AlertWindow::showMessageBoxAsync(juce::AlertWindow::WarningIcon, "Export Trace", "Couldn't write " + traceFile.getFullPathName());
+            }
+        });
+    }
+    else if (button == &resetButton) {
+        telemetry.reset();
+        stats = Telemetry::Stats();
+        repaint();
+    }
+}
+
+void TelemetryDisplay::resized() {
+    auto buttons = getLocalBounds().removeFromBottom(30);
+    resetButton.setBounds(buttons.removeFromRight(60).reduced(2));
+    exportButton.setBounds(buttons.reduced(2));
+}
+
+void TelemetryDisplay::paint(juce::Graphics& g) {
+    auto bounds = getLocalBounds();
+    bounds.removeFromBottom(30);
+    auto textColour = getLookAndFeel().findColour(juce::Label::textColourId);
+
+    g.setColour(textColour);
+    g.setFont(juce::FontOptions(13.0f));
+    g.drawText("CPU " + juce::String(stats.lastLoad * 100.0, 1) + "% (mean " + juce::String(stats.meanLoad * 100.0, 1)
+        + "%, peak " + juce::String(stats.peakLoad * 100.0, 1) + "%)", bounds.removeFromTop(16), juce::Justification::centredLeft);
+    g.drawText(juce::String(stats.blocks) + " blocks, " + juce::String(stats.overruns) + " over budget"
+        + (stats.droppedEvents > 0 ? ", " + juce::String(stats.droppedEvents) + " events dropped" : juce::String()),
+        bounds.removeFromTop(16), juce::Justification::centredLeft);
+
+    // One bar per 10% of the budget, log scaled so the odd slow block still shows up. Red is over budget.
+    auto area = bounds.reduced(0, 2);
+    g.drawRect(area);
+    area = area.reduced(1);
+    juce::int64 most = 0;
+    for (auto count : stats.histogram) most = juce::jmax(most, count);
+    if (most == 0) return;
+
+    float barWidth = area.getWidth() / float(Telemetry::numBuckets);
+    for (int i = 0; i < Telemetry::numBuckets; i++) {
+        if (stats.histogram[i] == 0) continue;
+        float height = area.getHeight() * float(std::log1p(double(stats.histogram[i])) / std::log1p(double(most)));
+        g.setColour(i >= 10 ? juce::Colour::fromRGB(192, 40, 40) : juce::Colour::fromRGB(90, 170, 230));
+        g.fillRect(area.getX() + i * barWidth, area.getBottom() - height, juce::jmax(1.0f, barWidth - 1.0f), height);
+    }
+}
+
+#endif
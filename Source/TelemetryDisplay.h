@@ -0,0 +1,49 @@
+/*
+  ==============================================================================
+
+    TelemetryDisplay.h
+    Created: 17 Oct 2026 7:38:16pm
+    Author:  DJ_Level_3
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "Telemetry.h"
+
+#if S3_TELEMETRY
+
+//==============================================================================
+/*
+    The diagnostics panel. Shows how much of the real-time budget processBlock
+    is using and how often it's gone over, with a histogram of block times,
+    and exports the trace.
+*/
+class TelemetryDisplay : public juce::Component, private juce::Timer, private juce::Button::Listener
+{
+public:
+    TelemetryDisplay(Telemetry& telemetry);
+    ~TelemetryDisplay() override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+private:
+    void timerCallback() override;
+    void buttonClicked(juce::Button* button) override;
+
+    // How often (Hz) the numbers get updated
+    static constexpr int refreshRate = 4;
+
+    Telemetry& telemetry;
+    Telemetry::Stats stats;
+
+    juce::TextButton exportButton{ "Export Trace..." };
+    juce::TextButton resetButton{ "Reset" };
+    juce::FileChooser traceChooser{ "Export Trace...", juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("S3 Trace.json"), "*.json" };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TelemetryDisplay)
+};
+
+#endif
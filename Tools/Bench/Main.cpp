@@ -0,0 +1,352 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 17 Oct 2026 3:11:05pm
+    Author:  DJ_Level_3
+
+    S3Bench - times SamplerSynthesizer::processBlock over a matrix of block
+    sizes, sample rates and playback settings and writes the results as JSON.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/SamplerSynthesizer.h"
+
+//==============================================================================
+// How long every test sample is, short enough that looping cases wrap a few times per run
+static constexpr double sampleSeconds = 0.2;
+// The note every case plays, A1 like the README says samples should be rendered at
+static constexpr int benchNote = 33;
+static constexpr double benchRootFrequency = 55;
+
+struct BenchCase {
+    juce::String kernel;
+    int blockSize = 512;
+    double hostRate = 48000;
+    double sampleRate = 48000;
+    bool loop = true;
+    bool pitchBend = false;
+    // Switch slots every this many blocks, 0 for never
+    int slotSwitch = 0;
+};
+
+struct BenchResult {
+    juce::int64 frames = 0;
+    double seconds = 0;
+};
+
+//==============================================================================
+/*
+    The per-frame render loop S3 used before it was vectorised, kept so the
+    current one has something to be compared against. Plays one buffer and
+    nothing else.
+*/
+class ScalarReference
+{
+public:
+    ScalarReference(const juce::AudioBuffer<float>& sample, double rootSampleRate)
+        : sample(sample), rootSampleRate(rootSampleRate)
+    {
+    }
+
+    void prepareToPlay(double sampleRate) {
+        this->sampleRate = sampleRate;
+    }
+
+    void setPitchBend(float wheelPosition) {
+        lastPB = pitchBend;
+        pitchBend = std::pow(2.0, wheelPosition * 2.0 / 12.0);
+    }
+
+    void reset() {
+        time = 0;
+        finished = false;
+    }
+
+    void processBlock(juce::AudioBuffer<float>& buffer, int beginSample, int endSample) {
+        int sampleNow = beginSample;
+        while (sampleNow < endSample) {
+            for (int c = 0; c < 2; c++) {
+                int index = int(time);
+                if (index < sample.getNumSamples() && finished == false) {
+                    float sampleHere = sample.getSample(c, index);
+                    float sampleNext = sample.getSample(c, (index + 1) % sample.getNumSamples());
+                    buffer.setSample(c, sampleNow, float(lerp_f(sampleHere, sampleNext, float(time - index))));
+                }
+                else {
+                    buffer.setSample(c, sampleNow, 0);
+                }
+            }
+            double actualPB = lerp_f(lastPB, pitchBend, (sampleNow - beginSample) / float(endSample - beginSample));
+            double increment = rootSampleRate / benchRootFrequency * frequency / sampleRate * actualPB;
+            time = time + increment;
+            sampleNow++;
+
+            if (int(time) >= sample.getNumSamples()) {
+                if (loop) time = time - sample.getNumSamples();
+                else finished = true;
+            }
+        }
+        lastPB = pitchBend;
+    }
+
+    bool loop = true;
+
+private:
+    static double lerp_f(double start, double end, double t) {
+        return (end - start) * t + start;
+    }
+
+    const juce::AudioBuffer<float>& sample;
+    const double rootSampleRate;
+    double sampleRate = 48000;
+    double frequency = SamplerSynthesizer::midiNoteNumberToFrequency(benchNote);
+    double time = 0;
+    double lastPB = 1;
+    double pitchBend = 1;
+    bool finished = false;
+};
+
+//==============================================================================
+// A stereo figure-of-eight at 55Hz, the kind of thing S3 normally plays
+static juce::AudioBuffer<float> makeSample(double sampleRate) {
+    int numFrames = int(sampleSeconds * sampleRate);
+    juce::AudioBuffer<float> sample(2, numFrames);
+    for (int i = 0; i < numFrames; i++) {
+        double phase = juce::MathConstants<double>::twoPi * benchRootFrequency * i / sampleRate;
+        sample.setSample(0, i, float(std::sin(phase)));
+        sample.setSample(1, i, float(std::sin(phase * 2.0)));
+    }
+    return sample;
+}
+
+static bool writeSample(const juce::AudioBuffer<float>& sample, double sampleRate, const juce::File& file) {
+    file.deleteFile();
+    std::unique_ptr<juce::FileOutputStream> stream = file.createOutputStream();
+    if (stream == nullptr) return false;
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer(wav.createWriterFor(stream.get(), sampleRate, 2, 32, {}, 0));
+    if (writer == nullptr) return false;
+    stream.release();
+    return writer->writeFromAudioSampleBuffer(sample, 0, sample.getNumSamples());
+}
+
+//==============================================================================
+static BenchResult runSynth(SamplerSynthesizer& synth, const BenchCase& c, int slot, juce::int64 frames) {
+    juce::AudioBuffer<float> buffer(2, c.blockSize);
+    synth.prepareToPlay(c.hostRate);
+    synth.setPitchBend(0);
+    synth.setPitchBend(0);
+    for (int s = slot; s < slot + 2; s++) {
+        synth.chooseSample(s);
+        synth.setCurrentSampleLoop(c.loop);
+    }
+    synth.chooseSample(slot);
+    synth.resetAllSamples();
+    synth.noteOn(benchNote);
+
+    // A one-shot gets retriggered whenever it would have run out, otherwise we'd just be timing silence
+    juce::int64 retrigger = juce::int64(sampleSeconds * c.hostRate);
+    juce::int64 sinceTrigger = 0;
+    int current = slot;
+
+    juce::int64 start = juce::Time::getHighResolutionTicks();
+    juce::int64 done = 0;
+    for (int block = 0; done < frames; block++) {
+        if (c.pitchBend) synth.setPitchBend(float(std::sin(block * 0.05)));
+        if (c.slotSwitch > 0 && block > 0 && block % c.slotSwitch == 0) {
+            current = current == slot ? slot + 1 : slot;
+            synth.chooseSample(current);
+        }
+        if (c.loop == false && sinceTrigger >= retrigger) {
+            synth.reset();
+            synth.noteOn(benchNote);
+            sinceTrigger = 0;
+        }
+        synth.processBlock(buffer, 0, c.blockSize);
+        done += c.blockSize;
+        sinceTrigger += c.blockSize;
+    }
+    juce::int64 end = juce::Time::getHighResolutionTicks();
+
+    synth.noteOff(benchNote);
+    return { done, juce::Time::highResolutionTicksToSeconds(end - start) };
+}
+
+static BenchResult runReference(ScalarReference& reference, const BenchCase& c, juce::int64 frames) {
+    juce::AudioBuffer<float> buffer(2, c.blockSize);
+    reference.prepareToPlay(c.hostRate);
+    reference.setPitchBend(0);
+    reference.setPitchBend(0);
+    reference.loop = c.loop;
+    reference.reset();
+
+    juce::int64 retrigger = juce::int64(sampleSeconds * c.hostRate);
+    juce::int64 sinceTrigger = 0;
+
+    juce::int64 start = juce::Time::getHighResolutionTicks();
+    juce::int64 done = 0;
+    for (int block = 0; done < frames; block++) {
+        if (c.pitchBend) reference.setPitchBend(float(std::sin(block * 0.05)));
+        if (c.loop == false && sinceTrigger >= retrigger) {
+            reference.reset();
+            sinceTrigger = 0;
+        }
+        reference.processBlock(buffer, 0, c.blockSize);
+        done += c.blockSize;
+        sinceTrigger += c.blockSize;
+    }
+    juce::int64 end = juce::Time::getHighResolutionTicks();
+
+    return { done, juce::Time::highResolutionTicksToSeconds(end - start) };
+}
+
+static void printUsage() {
+    std::cout << "Usage: S3Bench [--out <file.json>] [--quick] [--seconds <s>] [--repeats <n>] [--kernel synth|scalar]\n"
+                 "\n"
+                 "  --out <file>      Where to write the JSON results (default: print them)\n"
+                 "  --quick           Smaller matrix, for a quick look\n"
+                 "  --seconds <s>     Seconds of audio (at the host rate) rendered per run (default 1)\n"
+                 "  --repeats <n>     Runs per case, the fastest one is kept (default 5)\n"
+                 "  --kernel <name>   Only run one kernel, synth is the current one and scalar the old loop\n";
+}
+
+int main(int argc, char* argv[])
+{
+    // The loader posts messages, so there has to be a message manager even though nothing runs its loop
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::File outFile;
+    bool quick = false;
+    double seconds = 1;
+    int repeats = 5;
+    juce::String onlyKernel;
+    for (int i = 1; i < argc; i++) {
+        juce::String arg = juce::CharPointer_UTF8(argv[i]);
+        bool hasValue = i + 1 < argc;
+        if (arg == "--out" && hasValue) outFile = juce::File::getCurrentWorkingDirectory().getChildFile(juce::String(juce::CharPointer_UTF8(argv[++i])));
+        else if (arg == "--quick") quick = true;
+        else if (arg == "--seconds" && hasValue) seconds = juce::String(juce::CharPointer_UTF8(argv[++i])).getDoubleValue();
+        else if (arg == "--repeats" && hasValue) repeats = juce::jmax(1, juce::String(juce::CharPointer_UTF8(argv[++i])).getIntValue());
+        else if (arg == "--kernel" && hasValue) onlyKernel = juce::CharPointer_UTF8(argv[++i]);
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    juce::Array<int> blockSizes = quick ? juce::Array<int>{ 64, 512 } : juce::Array<int>{ 32, 64, 128, 256, 512, 1024, 2048 };
+    juce::Array<double> hostRates = quick ? juce::Array<double>{ 48000, 192000 } : juce::Array<double>{ 44100, 48000, 96000, 192000, 384000 };
+    juce::Array<double> sampleRates = quick ? juce::Array<double>{ 48000 } : juce::Array<double>{ 44100, 48000, 96000, 192000 };
+    juce::Array<int> slotSwitches = quick ? juce::Array<int>{ 0 } : juce::Array<int>{ 0, 16, 1 };
+    juce::StringArray kernels{ "synth", "scalar" };
+    if (onlyKernel.isNotEmpty()) kernels = juce::StringArray(onlyKernel);
+
+    // Every sample rate gets two slots (for the slot switching cases) holding the same file
+    auto synthOwner = std::make_unique<SamplerSynthesizer>();
+    SamplerSynthesizer& synth = *synthOwner;
+    juce::OwnedArray<juce::AudioBuffer<float>> samples;
+    juce::OwnedArray<ScalarReference> references;
+    juce::File tempDir = juce::File::getSpecialLocation(juce::File::tempDirectory).getNonexistentChildFile("S3Bench", "", false);
+    tempDir.createDirectory();
+    for (int i = 0; i < sampleRates.size(); i++) {
+        samples.add(new juce::AudioBuffer<float>(makeSample(sampleRates[i])));
+        references.add(new ScalarReference(*samples[i], sampleRates[i]));
+
+        juce::File file = tempDir.getChildFile("bench" + juce::String(i) + ".wav");
+        if (writeSample(*samples[i], sampleRates[i], file) == false) {
+            std::cerr << "Couldn't write " << file.getFullPathName() << "\n";
+            return 1;
+        }
+        synth.loadSample(file, benchRootFrequency, i * 2);
+        synth.loadSample(file, benchRootFrequency, i * 2 + 1);
+    }
+    while (synth.getLoader().isBusy()) {
+        juce::Thread::sleep(5);
+    }
+    for (int i = 0; i < sampleRates.size() * 2; i++) {
+        if (synth.isSampleLoading(i)) {
+            std::cerr << "Couldn't load the test samples\n";
+            return 1;
+        }
+    }
+
+    juce::Array<juce::var> results;
+    for (const juce::String& kernel : kernels) {
+        for (int blockSize : blockSizes) {
+            for (double hostRate : hostRates) {
+                for (int s = 0; s < sampleRates.size(); s++) {
+                    for (bool loop : { true, false }) {
+                        for (bool pitchBend : { false, true }) {
+                            for (int slotSwitch : slotSwitches) {
+                                // The old loop only ever plays one slot
+                                if (kernel == "scalar" && slotSwitch != 0) continue;
+
+                                BenchCase c;
+                                c.kernel = kernel;
+                                c.blockSize = blockSize;
+                                c.hostRate = hostRate;
+                                c.sampleRate = sampleRates[s];
+                                c.loop = loop;
+                                c.pitchBend = pitchBend;
+                                c.slotSwitch = slotSwitch;
+
+                                juce::int64 frames = juce::jmax(juce::int64(blockSize), juce::int64(seconds * hostRate));
+                                BenchResult best;
+                                for (int r = 0; r < repeats; r++) {
+                                    BenchResult result = kernel == "scalar" ? runReference(*references[s], c, frames) : runSynth(synth, c, s * 2, frames);
+                                    if (r == 0 || result.seconds < best.seconds) best = result;
+                                }
+
+                                double nsPerFrame = best.seconds * 1.0e9 / double(best.frames);
+                                juce::DynamicObject::Ptr row = new juce::DynamicObject();
+                                row->setProperty("kernel", c.kernel);
+                                row->setProperty("blockSize", c.blockSize);
+                                row->setProperty("hostRate", c.hostRate);
+                                row->setProperty("sampleRate", c.sampleRate);
+                                row->setProperty("rateRatio", c.sampleRate / c.hostRate);
+                                row->setProperty("loop", c.loop);
+                                row->setProperty("pitchBend", c.pitchBend);
+                                row->setProperty("slotSwitch", c.slotSwitch);
+                                row->setProperty("frames", best.frames);
+                                row->setProperty("nsPerFrame", nsPerFrame);
+                                row->setProperty("framesPerSecond", double(best.frames) / best.seconds);
+                                row->setProperty("realtimeFactor", double(best.frames) / best.seconds / c.hostRate);
+                                results.add(row.get());
+
+                                std::cout << c.kernel << " block " << c.blockSize << " host " << c.hostRate << " sample " << c.sampleRate
+                                          << (c.loop ? " loop" : " one-shot") << (c.pitchBend ? " bend" : "") << " switch " << c.slotSwitch
+                                          << ": " << juce::String(nsPerFrame, 2) << " ns/frame\n";
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // The synth might still have the files mapped
+    synthOwner.reset();
+    tempDir.deleteRecursively();
+
+    juce::DynamicObject::Ptr report = new juce::DynamicObject();
+    report->setProperty("version", ProjectInfo::versionString);
+    report->setProperty("date", juce::Time::getCurrentTime().toISO8601(true));
+    report->setProperty("cpu", juce::SystemStats::getCpuModel());
+    report->setProperty("os", juce::SystemStats::getOperatingSystemName());
+    report->setProperty("seconds", seconds);
+    report->setProperty("repeats", repeats);
+    report->setProperty("results", results);
+
+    juce::String json = juce::JSON::toString(juce::var(report.get()));
+    if (outFile == juce::File()) {
+        std::cout << json << "\n";
+    }
+    else if (outFile.replaceWithText(json) == false) {
+        std::cerr << "Couldn't write " << outFile.getFullPathName() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,316 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+    Created: 17 Oct 2026 2:03:47pm
+    Author:  DJ_Level_3
+
+    S3Render - drives the plugin from a MIDI file and writes the result
+    straight to a WAV/FLAC file, as fast as the CPU can go.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+//==============================================================================
+struct RenderSlot {
+    int slot = 0;
+    juce::File file;
+    double rootFrequency = 55;
+    bool loop = true;
+};
+
+struct RenderSettings {
+    juce::File state;
+    juce::Array<RenderSlot> slots;
+    int startSlot = -1;
+    juce::File midi;
+    juce::File output;
+    double sampleRate = 48000;
+    int blockSize = 512;
+    int bitDepth = 24;
+    int numChannels = 2;
+    double tail = 0;
+};
+
+// Always playing, so "Reset on Transport Start" behaves like pressing play in a DAW
+class RenderPlayHead : public juce::AudioPlayHead
+{
+public:
+    juce::Optional<PositionInfo> getPosition() const override {
+        PositionInfo info;
+        info.setIsPlaying(true);
+        info.setTimeInSamples(position);
+        return info;
+    }
+
+    juce::int64 position = 0;
+};
+
+static void printUsage() {
+    std::cout << "Usage: S3Render [--threads <n>] <job options>\n"
+                 "       S3Render [--threads <n>] --batch <file>\n"
+                 "\n"
+                 "Job options:\n"
+                 "  --midi <file>          MIDI file to play (required)\n"
+                 "  --out <file>           .wav or .flac file to write (required)\n"
+                 "  --state <file>         Plugin state to start from, XML with an S3 root or raw state data\n"
+                 "  --sample <slot> <file> Load a file into a slot, can be given more than once\n"
+                 "  --root <Hz>            Root frequency for the --sample files after it (default 55)\n"
+                 "  --one-shot             Don't loop the --sample files after it\n"
+                 "  --slot <n>             Slot to start playing from\n"
+                 "  --rate <Hz>            Sample rate to render at (default 48000)\n"
+                 "  --block <frames>       Block size to render with (default 512)\n"
+                 "  --bits <n>             Bit depth of the output (default 24)\n"
+                 "  --channels <n>         Channels in the output, e.g. 3 for XY plus Z (default 2)\n"
+                 "  --tail <seconds>       Extra time to render after the last MIDI event (default 0)\n"
+                 "\n"
+                 "A batch file has one job per line, every job gets rendered in parallel.\n";
+}
+
+// Returns an error if the arguments don't make sense
+static juce::Result parseJob(const juce::StringArray& args, RenderSettings& settings) {
+    double rootFrequency = 55;
+    bool loop = true;
+    for (int i = 0; i < args.size(); i++) {
+        const juce::String& arg = args[i];
+        bool hasValue = i + 1 < args.size();
+        if (arg == "--midi" && hasValue) settings.midi = juce::File::getCurrentWorkingDirectory().getChildFile(args[++i]);
+        else if (arg == "--out" && hasValue) settings.output = juce::File::getCurrentWorkingDirectory().getChildFile(args[++i]);
+        else if (arg == "--state" && hasValue) settings.state = juce::File::getCurrentWorkingDirectory().getChildFile(args[++i]);
+        else if (arg == "--sample" && i + 2 < args.size()) {
+            RenderSlot slot;
+            slot.slot = args[++i].getIntValue();
+            slot.file = juce::File::getCurrentWorkingDirectory().getChildFile(args[++i]);
+            slot.rootFrequency = rootFrequency;
+            slot.loop = loop;
+            if (slot.slot < 0 || slot.slot >= MAX_SAMPLES) return juce::Result::fail("Slot " + juce::String(slot.slot) + " is out of range");
+            settings.slots.add(slot);
+        }
+        else if (arg == "--root" && hasValue) rootFrequency = args[++i].getDoubleValue();
+        else if (arg == "--one-shot") loop = false;
+        else if (arg == "--slot" && hasValue) settings.startSlot = args[++i].getIntValue();
+        else if (arg == "--rate" && hasValue) settings.sampleRate = args[++i].getDoubleValue();
+        else if (arg == "--block" && hasValue) settings.blockSize = args[++i].getIntValue();
+        else if (arg == "--bits" && hasValue) settings.bitDepth = args[++i].getIntValue();
+        else if (arg == "--channels" && hasValue) settings.numChannels = args[++i].getIntValue();
+        else if (arg == "--tail" && hasValue) settings.tail = args[++i].getDoubleValue();
+        else return juce::Result::fail("Don't know what to do with " + arg);
+    }
+
+    if (settings.midi == juce::File()) return juce::Result::fail("No MIDI file given");
+    if (settings.output == juce::File()) return juce::Result::fail("No output file given");
+    if (settings.sampleRate <= 0 || settings.blockSize <= 0) return juce::Result::fail("Bad sample rate or block size");
+    if (settings.numChannels < 1 || settings.numChannels > SampleData::maxChannels) return juce::Result::fail("Bad number of channels");
+    return juce::Result::ok();
+}
+
+// The loader works on its own thread, wait for it to catch up
+static void waitForLoader(SamplerSynthesizer& synth) {
+    while (synth.getLoader().isBusy()) {
+        juce::Thread::sleep(5);
+    }
+}
+
+static juce::Result loadState(SimplerStereoSamplerAudioProcessor& processor, const RenderSettings& settings) {
+    if (settings.state != juce::File()) {
+        juce::MemoryBlock data;
+        if (settings.state.loadFileAsData(data) == false) return juce::Result::fail("Couldn't read " + settings.state.getFullPathName());
+
+        // Accept the XML the plugin saves as well as the binary blob a host stores
+        std::unique_ptr<juce::XmlElement> xml = juce::parseXML(data.toString());
+        if (xml != nullptr && xml->hasTagName("S3")) {
+            data.reset();
+            juce::AudioProcessor::copyXmlToBinary(*xml, data);
+        }
+        processor.setStateInformation(data.getData(), int(data.getSize()));
+    }
+
+    for (const RenderSlot& slot : settings.slots) {
+        processor.synth.unloadSample(slot.slot);
+        processor.synth.loadSample(slot.file, slot.rootFrequency, slot.slot, slot.loop);
+    }
+    if (settings.startSlot >= 0) {
+        *processor.slotNum = settings.startSlot;
+    }
+    waitForLoader(processor.synth);
+
+    // Offline we'd outrun the streamer, so everything gets loaded into memory
+    for (int i = 0; i < MAX_SAMPLES; i++) {
+        if (processor.synth.isSampleStreaming(i)) processor.synth.setSampleStreaming(i, false);
+    }
+    waitForLoader(processor.synth);
+
+    // Nothing runs the message loop here, so a failed load just stays loading
+    for (int i = 0; i < MAX_SAMPLES; i++) {
+        if (processor.synth.isSampleLoading(i)) return juce::Result::fail("Couldn't load slot " + juce::String(i));
+    }
+    return juce::Result::ok();
+}
+
+static juce::Result render(const RenderSettings& settings) {
+    juce::MidiFile midiFile;
+    {
+        juce::FileInputStream in(settings.midi);
+        if (in.failedToOpen() || midiFile.readFrom(in) == false) return juce::Result::fail("Couldn't read " + settings.midi.getFullPathName());
+    }
+    midiFile.convertTimestampTicksToSeconds();
+    juce::MidiMessageSequence events;
+    for (int i = 0; i < midiFile.getNumTracks(); i++) {
+        events.addSequence(*midiFile.getTrack(i), 0);
+    }
+
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+    juce::AudioFormat* format = formats.findFormatForFileExtension(settings.output.getFileExtension());
+    if (format == nullptr) return juce::Result::fail("Don't know how to write " + settings.output.getFileName());
+
+    SimplerStereoSamplerAudioProcessor processor;
+    processor.setPlayConfigDetails(0, settings.numChannels, settings.sampleRate, settings.blockSize);
+    juce::Result loaded = loadState(processor, settings);
+    if (loaded.failed()) return loaded;
+
+    settings.output.deleteFile();
+    std::unique_ptr<juce::FileOutputStream> stream = settings.output.createOutputStream();
+    if (stream == nullptr) return juce::Result::fail("Couldn't write to " + settings.output.getFullPathName());
+    std::unique_ptr<juce::AudioFormatWriter> writer(format->createWriterFor(stream.get(), settings.sampleRate, juce::uint32(settings.numChannels), settings.bitDepth, {}, 0));
+    if (writer == nullptr) return juce::Result::fail(format->getFormatName() + " can't do " + juce::String(settings.bitDepth) + " bits at " + juce::String(settings.sampleRate) + "Hz");
+    stream.release();
+
+    RenderPlayHead playHead;
+    processor.setPlayHead(&playHead);
+    processor.prepareToPlay(settings.sampleRate, settings.blockSize);
+
+    juce::AudioBuffer<float> buffer(settings.numChannels, settings.blockSize);
+    juce::MidiBuffer midi;
+    midi.ensureSize(4096);
+
+    juce::int64 totalFrames = juce::int64(std::llround((events.getEndTime() + settings.tail) * settings.sampleRate));
+    int nextEvent = 0;
+    for (juce::int64 frame = 0; frame < totalFrames; frame += settings.blockSize) {
+        int numFrames = int(juce::jmin(juce::int64(settings.blockSize), totalFrames - frame));
+
+        midi.clear();
+        while (nextEvent < events.getNumEvents()) {
+            const juce::MidiMessage& msg = events.getEventPointer(nextEvent)->message;
+            juce::int64 when = juce::int64(std::llround(msg.getTimeStamp() * settings.sampleRate));
+            if (when >= frame + numFrames) break;
+            midi.addEvent(msg, int(juce::jmax(juce::int64(0), when - frame)));
+            nextEvent++;
+        }
+
+        playHead.position = frame;
+        buffer.setSize(settings.numChannels, numFrames, false, false, true);
+        processor.processBlock(buffer, midi);
+        if (writer->writeFromAudioSampleBuffer(buffer, 0, numFrames) == false) {
+            return juce::Result::fail("Couldn't write to " + settings.output.getFullPathName());
+        }
+    }
+
+    processor.releaseResources();
+    processor.setPlayHead(nullptr);
+    return juce::Result::ok();
+}
+
+//==============================================================================
+class RenderJob : public juce::ThreadPoolJob
+{
+public:
+    RenderJob(const RenderSettings& settings)
+        : juce::ThreadPoolJob(settings.output.getFileName()), settings(settings)
+    {
+    }
+
+    JobStatus runJob() override {
+        juce::Time start = juce::Time::getCurrentTime();
+        result = render(settings);
+        seconds = (juce::Time::getCurrentTime() - start).inSeconds();
+        return jobHasFinished;
+    }
+
+    const RenderSettings settings;
+    juce::Result result = juce::Result::ok();
+    double seconds = 0;
+
+private:
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RenderJob)
+};
+
+int main(int argc, char* argv[])
+{
+    // The plugin's loader and parameters post messages, so there has to be a message manager even though
+    // nothing ever runs its loop
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::StringArray args;
+    for (int i = 1; i < argc; i++) {
+        args.add(juce::CharPointer_UTF8(argv[i]));
+    }
+
+    int numThreads = juce::SystemStats::getNumCpus();
+    int threadsArg = args.indexOf("--threads");
+    if (threadsArg >= 0 && threadsArg + 1 < args.size()) {
+        numThreads = juce::jmax(1, args[threadsArg + 1].getIntValue());
+        args.removeRange(threadsArg, 2);
+    }
+
+    // Every job is one line of arguments
+    juce::Array<juce::StringArray> jobArgs;
+    int batchArg = args.indexOf("--batch");
+    if (batchArg >= 0 && batchArg + 1 < args.size()) {
+        juce::StringArray lines;
+        juce::File::getCurrentWorkingDirectory().getChildFile(args[batchArg + 1]).readLines(lines);
+        for (const juce::String& line : lines) {
+            if (line.trim().isEmpty() || line.trim().startsWithChar('#')) continue;
+            juce::StringArray tokens;
+            tokens.addTokens(line, true);
+            for (juce::String& token : tokens) {
+                token = token.unquoted();
+            }
+            tokens.removeEmptyStrings();
+            jobArgs.add(tokens);
+        }
+    }
+    else if (args.isEmpty() == false) {
+        jobArgs.add(args);
+    }
+
+    if (jobArgs.isEmpty()) {
+        printUsage();
+        return 1;
+    }
+
+    juce::OwnedArray<RenderJob> jobs;
+    for (int i = 0; i < jobArgs.size(); i++) {
+        RenderSettings settings;
+        juce::Result parsed = parseJob(jobArgs[i], settings);
+        if (parsed.failed()) {
+            std::cerr << "Job " << i + 1 << ": " << parsed.getErrorMessage() << "\n";
+            printUsage();
+            return 1;
+        }
+        jobs.add(new RenderJob(settings));
+    }
+
+    juce::ThreadPool pool(juce::ThreadPoolOptions().withNumberOfThreads(juce::jmin(numThreads, jobs.size())));
+    for (RenderJob* job : jobs) {
+        pool.addJob(job, false);
+    }
+    while (pool.getNumJobs() > 0) {
+        juce::Thread::sleep(20);
+    }
+
+    int failures = 0;
+    for (RenderJob* job : jobs) {
+        if (job->result.failed()) {
+            std::cerr << job->settings.output.getFullPathName() << ": " << job->result.getErrorMessage() << "\n";
+            failures++;
+        }
+        else {
+            std::cout << job->settings.output.getFullPathName() << ": done in " << juce::String(job->seconds, 2) << "s\n";
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}